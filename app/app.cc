@@ -42,6 +42,8 @@ void App::run()
     this->window->clear(0.8, 0.2, 0.2);
     this->viewer->update(this->window->ratio(), this->elapsed);
     this->viewer->renderCurrModel();
+    this->viewer->renderInstances();
+    this->viewer->renderCrowds();
     this->window->swapBuffer();
   }
 }
@@ -0,0 +1,1128 @@
+// correctness checks for the fast paths of math/ and model/animation/, built
+// as its own program by `scons anim_test`. every check compares a fast path
+// with the reference it replaces and fails past a fixed tolerance, the
+// alloc_steady checks count operator new calls of Model::animate once warm.
+//
+//   ./anim_test                  runs every check, exits 1 if one fails
+//   ./anim_test --filter mat4    only checks whose name contains "mat4"
+//
+// clips are generated here, the checks do not depend on the models folder.
+
+#include "../math/batch.h"
+#include "../math/mat4.h"
+#include "../math/simd.h"
+#include "../math/transform.h"
+#include "../math/transformSoA.h"
+#include "../model/model.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+
+struct TestOptions
+{
+  std::string filter;
+};
+
+static int failures = 0;
+
+// every heap allocation of the program, the steady state checks compare it
+// before and after a run of frames
+static size_t allocations = 0;
+
+// kept out of line, gcc pairs the malloc and free it sees inlined into
+// callers and flags them as a mismatched new and delete
+__attribute__((noinline)) void *operator new(size_t size)
+{
+  allocations++;
+  void *p = malloc(size > 0 ? size : 1);
+  if (p == nullptr)
+  {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+__attribute__((noinline)) void operator delete(void *p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept { free(p); }
+
+/// @brief prints the outcome of one check, error is the largest deviation
+/// it measured
+static void report(const char *name, bool ok, double error, const char *detail = "")
+{
+  printf("%-36s %-4s %12.3g %s\n", name, ok ? "ok" : "FAIL", error, detail);
+  if (!ok)
+  {
+    failures++;
+  }
+}
+
+static void run(const TestOptions &options, const char *name, const std::function<void(const char *)> &check)
+{
+  if (!options.filter.empty() && std::string(name).find(options.filter) == std::string::npos)
+  {
+    return;
+  }
+  check(name);
+}
+
+static float maxError(const Mat4x4 &a, const Mat4x4 &b)
+{
+  float error = 0.0f;
+  for (int r = 0; r < 4; r++)
+  {
+    for (int c = 0; c < 4; c++)
+    {
+      error = fmaxf(error, fabsf(a.rc[r][c] - b.rc[r][c]));
+    }
+  }
+  return error;
+}
+
+static float maxError(const Vector4f &a, const Vector4f &b)
+{
+  float error = 0.0f;
+  for (int i = 0; i < 4; i++)
+  {
+    error = fmaxf(error, fabsf(a.v[i] - b.v[i]));
+  }
+  return error;
+}
+
+static Transform randomTransform()
+{
+  Transform t;
+  t.translation = Vector3f(random_float(-10, 10), random_float(-10, 10), random_float(-10, 10));
+  t.orientation = Quat(random_float(0, 360), Vector3f(random_float(-1, 1), random_float(-1, 1), random_float(-1, 1) + 2.0f));
+  t.scaling = Vector3f(random_float(1, 2), random_float(1, 2), random_float(1, 2));
+  return t;
+}
+
+// constexpr math
+//________________________________________________________________________
+//________________________________________________________________________
+
+/// @brief the series the cx_ functions of utils.h evaluate at compile time
+/// against the libm functions they call at run time, both rounded to float.
+/// absolute error for sin, cos and acos, relative for sqrt and tan
+static void checkConstexprMath(const char *name)
+{
+  double error = 0.0;
+  auto compare = [&](double series, float libm, bool relative)
+  {
+    double scale = relative ? fmax(1.0, fabs(libm)) : 1.0;
+    error = fmax(error, fabs((float)series - libm) / scale);
+  };
+  for (int i = 0; i <= 10000; i++)
+  {
+    float x = -20.0f + i * 0.004f;
+    compare(UtilsHelpers::sinSeries(x), sinf(x), false);
+    compare(UtilsHelpers::cosSeries(x), cosf(x), false);
+    compare(UtilsHelpers::sinSeries(x) / UtilsHelpers::cosSeries(x), tanf(x), true);
+
+    float c = -1.0f + i * 0.0002f;
+    compare(UtilsHelpers::acosSeries(c), acosf(c), false);
+
+    float v = i * i * 0.01f;
+    compare(UtilsHelpers::sqrtSeries(v), sqrtf(v), true);
+  }
+
+  report(name, error < 1e-6, error);
+}
+
+// mat4 kernels
+//________________________________________________________________________
+//________________________________________________________________________
+
+// inputs and results evaluated by the compiler through the constexpr scalar
+// operators
+
+struct Mat4Case
+{
+  Mat4x4 l;
+  Mat4x4 r;
+  Vector4f v;
+};
+
+static constexpr Mat4Case mat4Cases[] = {
+    {identity(), identity(), Vector4f(1.0f, 2.0f, 3.0f, 1.0f)},
+    {translate(Vector3f(1.0f, -2.0f, 3.0f)), scale(Vector3f(2.0f, 0.5f, 4.0f)), Vector4f(-1.0f, 0.5f, 2.0f, 1.0f)},
+    {rotationZ(30.0f) * translate(Vector3f(4.0f, 5.0f, -6.0f)), rotationX(-75.0f), Vector4f(0.25f, -3.0f, 7.0f, 0.0f)},
+    {scale(Vector3f(3.0f)) * rotationY(120.0f), translate(Vector3f(-8.0f, 0.0f, 2.5f)) * rotationZ(200.0f), Vector4f(1.0f)},
+    {perspective(60.0f, 1.5f, 0.1f, 100.0f), look_at(Vector3f(1.0f, 2.0f, 3.0f), Vector3f(0.0f, 0.0f, -1.0f), Vector3f(0.0f, 1.0f, 0.0f)), Vector4f(2.0f, -1.0f, -5.0f, 1.0f)},
+};
+static constexpr size_t mat4CaseCount = sizeof(mat4Cases) / sizeof(mat4Cases[0]);
+
+struct Mat4Expected
+{
+  Mat4x4 mul[mat4CaseCount];
+  Vector4f mulVec[mat4CaseCount];
+  Mat4x4 transpose[mat4CaseCount];
+  Mat4x4 inverseAffine[mat4CaseCount];
+};
+
+static constexpr Mat4Expected mat4Expect()
+{
+  Mat4Expected e;
+  for (size_t i = 0; i < mat4CaseCount; i++)
+  {
+    const Mat4Case &c = mat4Cases[i];
+    e.mul[i] = c.l * c.r;
+    e.mulVec[i] = c.l * c.v;
+    e.transpose[i] = c.l.transpose();
+    // the projection case is not affine, its inverse is skipped
+    e.inverseAffine[i] = i + 1 < mat4CaseCount ? c.l.inverseAffine() : identity();
+  }
+  return e;
+}
+static constexpr Mat4Expected mat4Expected = mat4Expect();
+
+static void checkMat4Kernels(const char *name, SimdLevel level)
+{
+  const Mat4Kernels &kernels = mat4Kernels(level);
+  float error = 0.0f;
+
+  for (size_t i = 0; i < mat4CaseCount; i++)
+  {
+    const Mat4Case &c = mat4Cases[i];
+    error = fmaxf(error, maxError(kernels.mul(c.l, c.r), mat4Expected.mul[i]));
+    error = fmaxf(error, maxError(kernels.mulVec(c.l, c.v), mat4Expected.mulVec[i]));
+    error = fmaxf(error, maxError(kernels.transpose(c.l), mat4Expected.transpose[i]));
+    if (i + 1 < mat4CaseCount)
+    {
+      error = fmaxf(error, maxError(kernels.inverseAffine(c.l), mat4Expected.inverseAffine[i]));
+    }
+  }
+
+  // random affine inputs against the same constexpr functions called at
+  // run time, and the batch in place
+  srand(99);
+  const size_t count = 256;
+  std::vector<Mat4x4> l(count), r(count), out(count);
+  for (size_t i = 0; i < count; i++)
+  {
+    l[i] = randomTransform().get();
+    r[i] = randomTransform().get();
+  }
+  kernels.mulBatch(l.data(), r.data(), out.data(), count);
+  for (size_t i = 0; i < count; i++)
+  {
+    Vector4f v(random_float(-5, 5), random_float(-5, 5), random_float(-5, 5), 1.0f);
+    Mat4x4 expected = mat4MulScalar(l[i], r[i]);
+    // relative to the size of the products
+    error = fmaxf(error, maxError(out[i], expected) / 100.0f);
+    error = fmaxf(error, maxError(kernels.mulVec(l[i], v), mat4MulVecScalar(l[i], v)) / 100.0f);
+    error = fmaxf(error, maxError(kernels.inverseAffine(l[i]), mat4InverseAffineScalar(l[i])));
+  }
+  std::vector<Mat4x4> inPlace = l;
+  kernels.mulBatch(inPlace.data(), r.data(), inPlace.data(), count);
+  for (size_t i = 0; i < count; i++)
+  {
+    error = fmaxf(error, maxError(inPlace[i], out[i]));
+  }
+
+  report(name, error < 1e-5f, error);
+}
+
+static void runMat4(const TestOptions &options)
+{
+  run(options, "constexpr_math", checkConstexprMath);
+
+  for (int level = SimdScalar; level <= simdLevel(); level++)
+  {
+    std::string name = std::string("mat4_kernels_") + simdLevelName((SimdLevel)level);
+    run(options, name.c_str(), [&](const char *name)
+        { checkMat4Kernels(name, (SimdLevel)level); });
+  }
+}
+
+// batch math
+//________________________________________________________________________
+//________________________________________________________________________
+
+/// @brief largest difference between two arrays of floats, relative to the
+/// larger of 1 and the largest expected value
+static float relativeError(const float *actual, const float *expected, size_t n)
+{
+  float error = 0.0f;
+  float size = 1.0f;
+  for (size_t i = 0; i < n; i++)
+  {
+    error = fmaxf(error, fabsf(actual[i] - expected[i]));
+    size = fmaxf(size, fabsf(expected[i]));
+  }
+  return error / size;
+}
+
+static float maxError(const Mat3x4 &a, const Mat3x4 &b) { return relativeError(&a.rc[0][0], &b.rc[0][0], 12); }
+static float maxError(const DualQuat &a, const DualQuat &b)
+{
+  return fmaxf(relativeError(a.real.v, b.real.v, 4), relativeError(a.dual.v, b.dual.v, 4));
+}
+static float maxError(const Transform &a, const Transform &b)
+{
+  return fmaxf(relativeError(a.translation.v, b.translation.v, 3),
+               fmaxf(relativeError(a.orientation.v, b.orientation.v, 4), relativeError(a.scaling.v, b.scaling.v, 3)));
+}
+
+static std::vector<Transform> randomTransforms(size_t count)
+{
+  std::vector<Transform> transforms(count);
+  for (Transform &t : transforms)
+  {
+    t = randomTransform();
+  }
+  return transforms;
+}
+
+/// @brief getBatch for every output type against Transform::get,
+/// getAffine and dualQuatFromTransform
+static void checkGetBatch(const char *name)
+{
+  srand(11);
+  const size_t count = 100;
+  std::vector<Transform> transforms = randomTransforms(count);
+  std::vector<Mat4x4> mats(count);
+  std::vector<Mat3x4> affines(count);
+  std::vector<DualQuat> dualQuats(count);
+  getBatch(transforms, mats);
+  getBatch(transforms, affines);
+  getBatch(transforms, dualQuats);
+
+  float error = 0.0f;
+  for (size_t i = 0; i < count; i++)
+  {
+    Mat4x4 expected = transforms[i].get();
+    error = fmaxf(error, relativeError(&mats[i].rc[0][0], &expected.rc[0][0], 16));
+    error = fmaxf(error, maxError(affines[i], transforms[i].getAffine()));
+    error = fmaxf(error, maxError(dualQuats[i], dualQuatFromTransform(transforms[i])));
+  }
+  report(name, error < 1e-6f, error);
+}
+
+/// @brief combineBatch against combine into a separate output, into the
+/// parents and into the children
+static void checkCombineBatch(const char *name)
+{
+  srand(12);
+  const size_t count = 100;
+  std::vector<Transform> parents = randomTransforms(count);
+  std::vector<Transform> children = randomTransforms(count);
+  std::vector<Transform> expected(count);
+  for (size_t i = 0; i < count; i++)
+  {
+    expected[i] = combine(parents[i], children[i]);
+  }
+
+  std::vector<Transform> out(count);
+  std::vector<Transform> intoParents = parents;
+  std::vector<Transform> intoChildren = children;
+  combineBatch(parents, children, out);
+  combineBatch(intoParents, children, intoParents);
+  combineBatch(parents, intoChildren, intoChildren);
+
+  float error = 0.0f;
+  for (size_t i = 0; i < count; i++)
+  {
+    error = fmaxf(error, maxError(out[i], expected[i]));
+    error = fmaxf(error, maxError(intoParents[i], expected[i]));
+    error = fmaxf(error, maxError(intoChildren[i], expected[i]));
+  }
+  report(name, error < 1e-6f, error, "(in place on both inputs)");
+}
+
+/// @brief mulBatch for every type against operator*, in place as well
+static void checkMulBatch(const char *name)
+{
+  srand(13);
+  const size_t count = 100;
+  std::vector<Transform> l = randomTransforms(count);
+  std::vector<Transform> r = randomTransforms(count);
+  std::vector<Mat4x4> l4(count), r4(count), out4(count);
+  std::vector<Mat3x4> l3(count), r3(count), out3(count);
+  std::vector<DualQuat> ld(count), rd(count), outd(count);
+  getBatch(l, l4);
+  getBatch(r, r4);
+  getBatch(l, l3);
+  getBatch(r, r3);
+  getBatch(l, ld);
+  getBatch(r, rd);
+
+  mulBatch(l4, r4, out4);
+  mulBatch(l3, r3, out3);
+  mulBatch(ld, rd, outd);
+  float error = 0.0f;
+  for (size_t i = 0; i < count; i++)
+  {
+    Mat4x4 expected = l4[i] * r4[i];
+    error = fmaxf(error, relativeError(&out4[i].rc[0][0], &expected.rc[0][0], 16));
+    error = fmaxf(error, maxError(out3[i], l3[i] * r3[i]));
+    error = fmaxf(error, maxError(outd[i], ld[i] * rd[i]));
+  }
+
+  mulBatch(l4, r4, l4);
+  mulBatch(l3, r3, r3);
+  mulBatch(ld, rd, ld);
+  for (size_t i = 0; i < count; i++)
+  {
+    error = fmaxf(error, relativeError(&l4[i].rc[0][0], &out4[i].rc[0][0], 16));
+    error = fmaxf(error, maxError(r3[i], out3[i]));
+    error = fmaxf(error, maxError(ld[i], outd[i]));
+  }
+  report(name, error < 1e-6f, error, "(in place as well)");
+}
+
+/// @brief normalBatch has to undo the transpose of the upper 3x3 block
+/// (transpose(m) * n = identity) for rigid, scaled and sheared matrices.
+/// isRigidBatch only accepts rotations times a uniform scale
+static void checkNormalBatch(const char *name)
+{
+  srand(14);
+  const size_t count = 30;
+  std::vector<Mat3x4> rigid(count), scaled(count), sheared(count);
+  for (size_t i = 0; i < count; i++)
+  {
+    Transform t = randomTransform();
+    float uniform = t.scaling.x;
+    scaled[i] = t.getAffine();
+    t.scaling = Vector3f(uniform);
+    rigid[i] = t.getAffine();
+    // a rotation after a non uniform scale after a rotation
+    sheared[i] = Mat3x4(t.orientation.toMat4x4()) * scaled[i];
+  }
+
+  float error = 0.0f;
+  for (std::vector<Mat3x4> *palette : {&rigid, &scaled, &sheared})
+  {
+    std::vector<Mat3x3> normals(count);
+    normalBatch(*palette, normals);
+    for (size_t i = 0; i < count; i++)
+    {
+      const Mat3x4 &m = (*palette)[i];
+      for (int r = 0; r < 3; r++)
+      {
+        for (int c = 0; c < 3; c++)
+        {
+          float product = m.rc[0][r] * normals[i].rc[0][c] + m.rc[1][r] * normals[i].rc[1][c] + m.rc[2][r] * normals[i].rc[2][c];
+          error = fmaxf(error, fabsf(product - (r == c ? 1.0f : 0.0f)));
+        }
+      }
+    }
+  }
+
+  // one non rigid matrix is enough to need the normal palette
+  std::vector<Mat3x4> mixed = rigid;
+  mixed[count / 2] = scaled[count / 2];
+  bool rigidOk = isRigidBatch(rigid) && !isRigidBatch(scaled) && !isRigidBatch(sheared) && !isRigidBatch(mixed);
+
+  report(name, error < 1e-5f && rigidOk, error, rigidOk ? "" : "(isRigidBatch wrong)");
+}
+
+static void runBatch(const TestOptions &options)
+{
+  run(options, "batch_get", [](const char *name)
+      { checkGetBatch(name); });
+  run(options, "batch_combine", [](const char *name)
+      { checkCombineBatch(name); });
+  run(options, "batch_mul", [](const char *name)
+      { checkMulBatch(name); });
+  run(options, "batch_normal", [](const char *name)
+      { checkNormalBatch(name); });
+}
+
+// soa kernels
+//________________________________________________________________________
+//________________________________________________________________________
+
+/// @brief combineSoA, getSoA and normalizeSoA with the lanes of level
+/// against combine, Transform::get and Quat::unit per joint. combine runs
+/// into a separate output and in place on the parents
+static void checkSoAKernels(const char *name, SimdLevel level)
+{
+  // not a multiple of 8, the last group of lanes is partly padding
+  const size_t count = 203;
+  srand(8);
+  std::vector<Transform> parents = randomTransforms(count);
+  std::vector<Transform> children = randomTransforms(count);
+
+  TransformSoA a(count), b(count), out;
+  a.load(parents);
+  b.load(children);
+  combineSoA(a, b, out, level);
+  std::vector<Mat4x4> mats(count);
+  getSoA(a, mats, level);
+
+  float error = 0.0f;
+  for (size_t i = 0; i < count; i++)
+  {
+    error = fmaxf(error, maxError(out.getTransform(i), combine(parents[i], children[i])));
+    Mat4x4 expected = parents[i].get();
+    error = fmaxf(error, relativeError(&mats[i].rc[0][0], &expected.rc[0][0], 16));
+  }
+
+  TransformSoA inPlace(count);
+  inPlace.load(parents);
+  combineSoA(inPlace, b, inPlace, level);
+  for (size_t i = 0; i < count; i++)
+  {
+    error = fmaxf(error, maxError(inPlace.getTransform(i), out.getTransform(i)));
+  }
+
+  // orientations off unit length by up to a factor of 2 either way
+  for (size_t i = 0; i < count; i++)
+  {
+    Transform t = parents[i];
+    t.orientation = t.orientation * (0.5f + 1.5f * random_float());
+    a.setTransform(i, t);
+  }
+  normalizeSoA(a, level);
+  for (size_t i = 0; i < count; i++)
+  {
+    error = fmaxf(error, relativeError(a.getTransform(i).orientation.v, parents[i].orientation.unit().v, 4));
+  }
+
+  report(name, error < 1e-5f, error);
+}
+
+/// @brief radians between approx and slerp(from, to, t) evaluated in double
+/// precision, over the shortest arc like the interpolation functions
+static double slerpError(const Quat &from, const Quat &to, float t, const Quat &approx)
+{
+  double ca = (double)from.x * to.x + (double)from.y * to.y + (double)from.z * to.z + (double)from.s * to.s;
+  double sign = ca < 0.0 ? -1.0 : 1.0;
+  double angle = acos(fmin(ca * sign, 1.0));
+  double w0 = angle < 1e-9 ? 1.0 - t : sin((1.0 - t) * angle) / sin(angle);
+  double w1 = angle < 1e-9 ? t : sign * sin(t * angle) / sin(angle);
+
+  double ex = w0 * from.x + w1 * to.x, ey = w0 * from.y + w1 * to.y;
+  double ez = w0 * from.z + w1 * to.z, es = w0 * from.s + w1 * to.s;
+
+  // vector part and scalar part of conjugate(exact) * approx
+  double x = es * approx.x - ex * approx.s - ey * approx.z + ez * approx.y;
+  double y = es * approx.y - ey * approx.s - ez * approx.x + ex * approx.z;
+  double z = es * approx.z - ez * approx.s - ex * approx.y + ey * approx.x;
+  double s = es * approx.s + ex * approx.x + ey * approx.y + ez * approx.z;
+  return 2.0 * atan2(sqrt(x * x + y * y + z * z), fabs(s));
+}
+
+/// @brief interpolateSoA with the lanes of level against slerp. the keys
+/// are up to 180 degrees apart, every other pair in opposite hemispheres.
+/// the results have to be unit length, position and scale match a scalar
+/// lerp and the call in place matches the one into a separate output
+static void checkInterpolateSoA(const char *name, QuatInterp mode, SimdLevel level, double bound)
+{
+  // not a multiple of 8, the last group of lanes is partly padding
+  const size_t count = 203;
+  srand(7);
+  std::vector<Transform> from(count), to(count);
+  std::vector<float> t(count);
+  for (size_t i = 0; i < count; i++)
+  {
+    from[i] = randomTransform();
+    to[i] = randomTransform();
+    to[i].orientation = (from[i].orientation * Quat(180.0f * i / (count - 1), Vector3f(random_float(-1, 1), random_float(-1, 1), 1.0f))).unit();
+    if (i % 2)
+    {
+      to[i].orientation = -1.0f * to[i].orientation;
+    }
+    t[i] = i % 17 == 0 ? (float)(i % 2) : random_float(0, 1);
+  }
+
+  TransformSoA a(count), b(count), out;
+  a.load(from);
+  b.load(to);
+  interpolateSoA(a, b, t, out, mode, level);
+
+  double angle = 0.0;
+  float linear = 0.0f;
+  float length = 0.0f;
+  for (size_t i = 0; i < count; i++)
+  {
+    Transform result = out.getTransform(i);
+    angle = fmax(angle, slerpError(from[i].orientation, to[i].orientation, t[i], result.orientation));
+    length = fmaxf(length, fabsf(1.0f - sqrtf(dot(result.orientation, result.orientation))));
+    for (int c = 0; c < 3; c++)
+    {
+      float position = from[i].translation.v[c] + (to[i].translation.v[c] - from[i].translation.v[c]) * t[i];
+      float scaling = from[i].scaling.v[c] + (to[i].scaling.v[c] - from[i].scaling.v[c]) * t[i];
+      linear = fmaxf(linear, fabsf(result.translation.v[c] - position));
+      linear = fmaxf(linear, fabsf(result.scaling.v[c] - scaling));
+    }
+  }
+
+  interpolateSoA(a, b, t, a, mode, level);
+  bool inPlace = true;
+  for (int s = 0; s < SoAStreamCount; s++)
+  {
+    inPlace = inPlace && memcmp(a.stream((SoAStream)s), out.stream((SoAStream)s), count * sizeof(float)) == 0;
+  }
+
+  char detail[96];
+  snprintf(detail, sizeof(detail), "(rad, bound %.3g, length %.3g, linear %.3g%s)", bound, length, linear,
+           inPlace ? "" : ", differs in place");
+  report(name, angle < bound && length < 1e-5f && linear < 1e-5f && inPlace, angle, detail);
+}
+
+static void runSoA(const TestOptions &options)
+{
+  for (int level = SimdSSE4; level <= simdLevel(); level++)
+  {
+    std::string name = std::string("soa_kernels") + (level == SimdAVX2 ? "_8_lanes" : "_4_lanes");
+    run(options, name.c_str(), [&](const char *name)
+        { checkSoAKernels(name, (SimdLevel)level); });
+  }
+
+  struct
+  {
+    QuatInterp mode;
+    const char *name;
+    // the bounds documented on QuatInterp
+    double bound;
+  } modes[] = {
+      {QuatNlerp, "nlerp", 0.15},
+      {QuatFastNlerp, "fast_nlerp", 1e-3},
+      {QuatSlerp, "slerp", 1e-5},
+  };
+
+  // every level below avx2 runs the 4 lane kernels
+  for (int level = SimdSSE4; level <= simdLevel(); level++)
+  {
+    for (auto &mode : modes)
+    {
+      std::string name = std::string("soa_interpolate_") + mode.name + (level == SimdAVX2 ? "_8_lanes" : "_4_lanes");
+      run(options, name.c_str(), [&](const char *name)
+          { checkInterpolateSoA(name, mode.mode, (SimdLevel)level, mode.bound); });
+    }
+  }
+}
+
+// packed clips
+//________________________________________________________________________
+//________________________________________________________________________
+
+/// @brief joints chained root to tip, each with keyed position, rotation
+/// and scale over two seconds at uneven times. every third joint only
+/// animates its rotation so the packed channel masks get exercised
+static Clip makeClip(size_t joints, Interpolation interpolation)
+{
+  Clip clip;
+  clip.resize(joints);
+  for (size_t j = 0; j < joints; j++)
+  {
+    TransformTrack &track = clip.getTrack(j);
+    track.setId(j);
+    QuatTrack &rotation = track.getRotationTrack();
+    VectorTrack &position = track.getPosTrack();
+    VectorTrack &scaling = track.getScalingTrack();
+    rotation.interpolation = interpolation;
+    position.interpolation = interpolation;
+    scaling.interpolation = interpolation;
+
+    for (size_t k = 0; k <= 24; k++)
+    {
+      // keys bunch up towards the end of the clip
+      float time = 2.0f * sqrtf(k / 24.0f);
+      Quat q = Quat(70.0f * sinf(time * 2.0f + j), Vector3f(1.0f, (float)j, 2.0f).unit());
+
+      Frame<4> r = {};
+      r.time = time;
+      r.m_value[0] = q.x;
+      r.m_value[1] = q.y;
+      r.m_value[2] = q.z;
+      r.m_value[3] = q.s;
+      rotation.frames.push_back(r);
+
+      if (j % 3 == 2)
+      {
+        continue;
+      }
+      Frame<3> p = {};
+      p.time = time;
+      p.m_value[0] = sinf(time * 3.0f + j);
+      p.m_value[1] = 1.0f;
+      p.m_value[2] = cosf(time);
+      position.frames.push_back(p);
+
+      Frame<3> sc = {};
+      sc.time = time;
+      sc.m_value[0] = 1.0f + 0.3f * sinf(time * j);
+      sc.m_value[1] = 1.0f;
+      sc.m_value[2] = 1.0f;
+      scaling.frames.push_back(sc);
+    }
+  }
+  clip.ReCalculateDuartion();
+  return clip;
+}
+
+static Pose makePose(size_t joints)
+{
+  Pose pose(joints);
+  for (size_t j = 0; j < joints; j++)
+  {
+    pose.setParent(j, (int)j - 1);
+  }
+  // as the loaders do, so copies of it come with the order built
+  pose.updateJointOrder();
+  return pose;
+}
+
+/// @brief largest difference of translation and scale, and of rotation in
+/// radians, between the local transforms of two poses
+static void poseError(Pose &a, Pose &b, float &linear, float &angle)
+{
+  std::span<Transform> x = a.getLocalTransforms();
+  std::span<Transform> y = b.getLocalTransforms();
+  for (size_t j = 0; j < x.size(); j++)
+  {
+    for (int c = 0; c < 3; c++)
+    {
+      linear = fmaxf(linear, fabsf(x[j].translation.v[c] - y[j].translation.v[c]));
+      linear = fmaxf(linear, fabsf(x[j].scaling.v[c] - y[j].scaling.v[c]));
+    }
+    // from the chord between the quaternions, acos of their dot product
+    // loses most of its precision near 1
+    Quat q = x[j].orientation;
+    Quat r = dot(q, y[j].orientation) < 0.0f ? -1.0f * y[j].orientation : y[j].orientation;
+    float chord = sqrtf((q.x - r.x) * (q.x - r.x) + (q.y - r.y) * (q.y - r.y) +
+                        (q.z - r.z) * (q.z - r.z) + (q.s - r.s) * (q.s - r.s));
+    angle = fmaxf(angle, 4.0f * asinf(fminf(chord * 0.5f, 1.0f)));
+  }
+}
+
+/// @brief the lane sampler of a packed clip against the per track sampler
+/// of the same clip baked at the same rate, both linear on the same grid.
+/// the times fall between keys, before the start and past the end
+static void checkPackedClip(const char *name, size_t joints, Interpolation interpolation)
+{
+  const float rate = 30.0f;
+  Clip baked = makeClip(joints, interpolation);
+  baked.bake(rate);
+  Clip packed = makeClip(joints, interpolation);
+  packed.pack(rate);
+
+  Pose expected = makePose(joints);
+  Pose actual = makePose(joints);
+  ClipCursor cursor;
+  float linear = 0.0f;
+  float angle = 0.0f;
+  for (int i = 0; i < 500; i++)
+  {
+    float time = -0.5f + i * 0.00731f;
+    baked.sample(expected, time, cursor);
+    packed.sample(actual, time);
+    poseError(expected, actual, linear, angle);
+  }
+
+  char detail[64];
+  snprintf(detail, sizeof(detail), "(%.3g rad)", angle);
+  report(name, packed.isPacked() && linear < 1e-4f && angle < 1e-3f, linear, detail);
+}
+
+static void runPacked(const TestOptions &options)
+{
+  // 13 joints leaves a partly filled group of lanes. step channels are not
+  // checked, a baked clip keeps them stepped where packing makes them linear
+  run(options, "packed_clip_linear", [](const char *name)
+      { checkPackedClip(name, 13, Linear); });
+  run(options, "packed_clip_cubic", [](const char *name)
+      { checkPackedClip(name, 13, Cubic); });
+  run(options, "packed_clip_cubic_40_joints", [](const char *name)
+      { checkPackedClip(name, 40, Cubic); });
+}
+
+// compressed clips
+//________________________________________________________________________
+//________________________________________________________________________
+
+/// @brief a clip of joints that only animate their position along x, one
+/// joint per list of times and values
+static Clip makePositionClip(const std::vector<std::vector<float>> &times, const std::vector<std::vector<float>> &values)
+{
+  Clip clip;
+  clip.resize(times.size());
+  for (size_t j = 0; j < times.size(); j++)
+  {
+    TransformTrack &track = clip.getTrack(j);
+    track.setId(j);
+    VectorTrack &position = track.getPosTrack();
+    position.interpolation = Linear;
+    for (size_t k = 0; k < times[j].size(); k++)
+    {
+      Frame<3> p = {};
+      p.time = times[j][k];
+      p.m_value[0] = values[j][k];
+      position.frames.push_back(p);
+    }
+  }
+  clip.ReCalculateDuartion();
+  return clip;
+}
+
+/// @brief largest pose error of a compressed copy of clip against clip at
+/// the given times. the times stay off the clip start, a looping clip maps
+/// it to the end where the tracks wrap back to their first key and the
+/// compressed channels hold their last
+static void compressedError(Clip clip, const CompressionSettings &settings, std::span<const float> times,
+                            CompressionReport &compression, float &linear, float &angle)
+{
+  Clip compressed = clip;
+  compression = compressed.compress(settings);
+
+  Pose expected = makePose(clip.size());
+  Pose actual = makePose(clip.size());
+  ClipCursor expectedCursor, actualCursor;
+  for (float time : times)
+  {
+    clip.sample(expected, time, expectedCursor);
+    compressed.sample(actual, time, actualCursor);
+    poseError(expected, actual, linear, angle);
+  }
+}
+
+/// @brief the compressed sampler against the tracks it came from, within
+/// twice the default tolerances
+static void checkCompressedClip(const char *name)
+{
+  std::vector<float> times;
+  for (int i = 0; i < 500; i++)
+  {
+    times.push_back(0.001f + i * 0.00401f);
+  }
+  CompressionReport compression;
+  float linear = 0.0f;
+  float angle = 0.0f;
+  compressedError(makeClip(13, Linear), CompressionSettings(), times, compression, linear, angle);
+
+  char detail[64];
+  snprintf(detail, sizeof(detail), "(%.3g rad, %zu -> %zu keys)", angle, compression.keysBefore, compression.keysAfter);
+  report(name, compression.keysAfter < compression.keysBefore && linear < 2e-3f && angle < 2e-3f, linear, detail);
+}
+
+/// @brief two keys 1e-5 s apart in a 1000 s channel share a 16 bit time
+/// step. that channel has to keep float times and still ramp between them,
+/// the evenly keyed one next to it stays quantized
+static void checkCompressedFloatTimes(const char *name)
+{
+  Clip clip = makePositionClip({{0.0f, 1.0f, 1.00001f, 1000.0f}, {0.0f, 250.0f, 500.0f, 750.0f, 1000.0f}},
+                               {{0.0f, 0.0f, 1.0f, 1.0f}, {0.0f, 2.0f, 1.0f, 3.0f, 0.0f}});
+  float times[] = {0.5f, 1.0f, 1.000002f, 1.000005f, 1.000008f, 2.0f, 400.0f, 999.0f};
+  CompressionReport compression;
+  float linear = 0.0f;
+  float angle = 0.0f;
+  compressedError(clip, CompressionSettings(), times, compression, linear, angle);
+
+  char detail[64];
+  snprintf(detail, sizeof(detail), "(%zu channels with float times)", compression.floatTimeChannels);
+  report(name, compression.floatTimeChannels == 1 && linear < 2e-3f, linear, detail);
+}
+
+/// @brief 20000 keys on a straight line, every key but the ends is
+/// redundant. segments stop at MAX_SEGMENT_KEYS (64) keys, which keeps
+/// reduce linear in the key count
+static void checkCompressedLongChannel(const char *name)
+{
+  const size_t count = 20000;
+  std::vector<float> keyTimes(count), values(count);
+  for (size_t k = 0; k < count; k++)
+  {
+    keyTimes[k] = k / 60.0f;
+    values[k] = k * 0.001f;
+  }
+  std::vector<float> times;
+  for (int i = 0; i < 500; i++)
+  {
+    times.push_back(0.001f + i * 0.6673f);
+  }
+  CompressionReport compression;
+  float linear = 0.0f;
+  float angle = 0.0f;
+  compressedError(makePositionClip({keyTimes}, {values}), CompressionSettings(), times, compression, linear, angle);
+
+  size_t expected = 1 + (count - 1 + 63) / 64;
+  char detail[64];
+  snprintf(detail, sizeof(detail), "(%zu -> %zu keys)", compression.keysBefore, compression.keysAfter);
+  report(name, compression.keysAfter == expected && linear < 2e-3f, linear, detail);
+}
+
+static void runCompressed(const TestOptions &options)
+{
+  run(options, "compressed_clip", checkCompressedClip);
+  run(options, "compressed_clip_float_times", checkCompressedFloatTimes);
+  run(options, "compressed_clip_long_channel", checkCompressedLongChannel);
+}
+
+// blending
+//________________________________________________________________________
+//________________________________________________________________________
+
+/// @brief two different poses of one skeleton, the clip at two times
+static void makeBlendPoses(Pose &a, Pose &b)
+{
+  const size_t joints = 13;
+  Clip clip = makeClip(joints, Linear);
+  a = makePose(joints);
+  b = makePose(joints);
+  clip.sample(a, 0.3f);
+  clip.sample(b, 1.7f);
+}
+
+/// @brief makeAdditivePose then addPose at weight 1 has to give back the
+/// pose the difference was taken from, in place and into another pose
+static void checkAdditiveRoundTrip(const char *name)
+{
+  Pose base, pose;
+  makeBlendPoses(base, pose);
+  Pose additive = base;
+  makeAdditivePose(additive, pose, base);
+
+  Pose result = base;
+  addPose(result, base, additive, 1.0f);
+  float linear = 0.0f;
+  float angle = 0.0f;
+  poseError(result, pose, linear, angle);
+
+  Pose inPlace = base;
+  addPose(inPlace, inPlace, additive, 1.0f);
+  poseError(inPlace, pose, linear, angle);
+
+  char detail[64];
+  snprintf(detail, sizeof(detail), "(%.3g rad)", angle);
+  report(name, linear < 1e-5f && angle < 1e-5f, linear, detail);
+}
+
+/// @brief blendPose at t = 0 and t = 1 returns its inputs, with and without
+/// a mask
+static void checkBlendEnds(const char *name)
+{
+  Pose a, b;
+  makeBlendPoses(a, b);
+  std::vector<float> mask(a.size(), 1.0f);
+
+  float linear = 0.0f;
+  float angle = 0.0f;
+  Pose result = a;
+  blendPose(result, a, b, 0.0f);
+  poseError(result, a, linear, angle);
+  blendPose(result, a, b, 1.0f);
+  poseError(result, b, linear, angle);
+  blendPose(result, a, b, 0.0f, mask);
+  poseError(result, a, linear, angle);
+  blendPose(result, a, b, 1.0f, mask);
+  poseError(result, b, linear, angle);
+
+  char detail[64];
+  snprintf(detail, sizeof(detail), "(%.3g rad)", angle);
+  report(name, linear < 1e-6f && angle < 1e-5f, linear, detail);
+}
+
+static void runBlending(const TestOptions &options)
+{
+  run(options, "blend_additive_round_trip", [](const char *name)
+      { checkAdditiveRoundTrip(name); });
+  run(options, "blend_pose_ends", [](const char *name)
+      { checkBlendEnds(name); });
+}
+
+// batch sampling
+//________________________________________________________________________
+//________________________________________________________________________
+
+enum ClipStorage
+{
+  StoreKeyframes,
+  StoreCompressed,
+  StorePacked,
+};
+
+/// @brief makeClip(joints, Linear) kept as tracks, compressed or packed
+static Clip makeStoredClip(size_t joints, ClipStorage storage)
+{
+  Clip clip = makeClip(joints, Linear);
+  if (storage == StoreCompressed)
+  {
+    clip.compress(CompressionSettings());
+  }
+  else if (storage == StorePacked)
+  {
+    clip.pack(30.0f);
+  }
+  return clip;
+}
+
+/// @brief Clip::sample over a batch of poses against Clip::sample of each
+/// pose with its own cursor, which has to match exactly. pairs of poses
+/// share a time and every fourth pose has one of its own, some before the
+/// start and past the end. the times advance for a few frames so the batch
+/// cursors are reused
+static void checkBatchSample(const char *name, ClipStorage storage)
+{
+  const size_t joints = 13;
+  const size_t count = 16;
+  Clip clip = makeStoredClip(joints, storage);
+
+  std::vector<Pose> actual(count, makePose(joints));
+  std::vector<Pose> expected(count, makePose(joints));
+  std::vector<ClipCursor> cursors(count);
+  std::vector<float> times(count);
+  ClipBatch batch;
+  float linear = 0.0f;
+  float angle = 0.0f;
+  bool sameTimes = true;
+  for (int frame = 0; frame < 50; frame++)
+  {
+    for (size_t k = 0; k < count; k++)
+    {
+      times[k] = (k % 4 == 3 ? -1.3f + 0.61f * k : 0.37f * (k / 2)) + frame / 60.0f;
+    }
+    clip.sample(actual, times, batch);
+    for (size_t k = 0; k < count; k++)
+    {
+      float time = clip.sample(expected[k], times[k], cursors[k]);
+      sameTimes = sameTimes && time == batch.times[k];
+      poseError(expected[k], actual[k], linear, angle);
+    }
+  }
+
+  char detail[64];
+  snprintf(detail, sizeof(detail), "(%.3g rad%s)", angle, sameTimes ? "" : ", clip times differ");
+  report(name, sameTimes && linear == 0.0f && angle == 0.0f, linear, detail);
+}
+
+static void runBatchSample(const TestOptions &options)
+{
+  run(options, "batch_sample_keyframes", [](const char *name)
+      { checkBatchSample(name, StoreKeyframes); });
+  run(options, "batch_sample_compressed", [](const char *name)
+      { checkBatchSample(name, StoreCompressed); });
+  run(options, "batch_sample_packed", [](const char *name)
+      { checkBatchSample(name, StorePacked); });
+}
+
+// steady state allocations
+//________________________________________________________________________
+//________________________________________________________________________
+
+/// @brief a model playing a clip frame after frame the way the viewer does
+/// (animate, skin palette, normal palette, dual quaternion palette). after
+/// a few warm up frames none of it may touch the heap. with blend set a
+/// second clip plays as an additive and as a masked layer, and a cross fade
+/// started during the warm up runs through part of the counted frames
+static void checkSteadyState(const char *name, ClipStorage storage, bool blend = false)
+{
+  const size_t joints = 40;
+  Model model;
+  model.skeleton.restPose = makePose(joints);
+  model.skeleton.inversePose.assign(joints, Transform().getAffine());
+  model.skeleton.inverseDualPose.resize(joints);
+
+  model.clips.push_back(makeStoredClip(joints, storage));
+  model.currAnim = 0;
+
+  if (blend)
+  {
+    model.clips.push_back(makeClip(joints, Cubic));
+
+    AnimationLayer &additive = model.layers.emplace_back();
+    additive.clip = 1;
+    additive.weight = 0.5f;
+    additive.additive = true;
+
+    AnimationLayer &masked = model.layers.emplace_back();
+    masked.clip = 1;
+    masked.weight = 0.7f;
+    subtreeMask(model.skeleton.restPose, joints / 2, masked.mask);
+  }
+
+  // the caller owned palettes, allocated once
+  std::vector<Mat3x4> palette(joints);
+  std::vector<Mat3x3> normals(joints);
+  std::vector<DualQuat> dualQuats(joints);
+
+  float time = 0.0f;
+  auto frame = [&]()
+  {
+    model.animate(time);
+    model.getPose(palette);
+    model.getNormalPose(palette, normals);
+    model.getDualPose(dualQuats);
+    time += 1.0f / 60.0f;
+  };
+  for (int i = 0; i < 3; i++)
+  {
+    if (blend && i == 1)
+    {
+      // ends after about 600 of the counted frames
+      model.crossFade(1, 10.0f);
+    }
+    frame();
+  }
+
+  // long enough to loop the clip several times
+  size_t before = allocations;
+  for (int i = 0; i < 1000; i++)
+  {
+    frame();
+  }
+  size_t counted = allocations - before;
+
+  report(name, counted == 0, (double)counted, "(allocations in 1000 frames)");
+}
+
+static void runSteadyState(const TestOptions &options)
+{
+  run(options, "alloc_steady_keyframes", [](const char *name)
+      { checkSteadyState(name, StoreKeyframes); });
+  run(options, "alloc_steady_compressed", [](const char *name)
+      { checkSteadyState(name, StoreCompressed); });
+  run(options, "alloc_steady_packed", [](const char *name)
+      { checkSteadyState(name, StorePacked); });
+  run(options, "alloc_steady_blend", [](const char *name)
+      { checkSteadyState(name, StoreKeyframes, true); });
+}
+
+static void usage(const char *program)
+{
+  printf("usage: %s [--filter name]\n", program);
+}
+
+int main(int argc, char **argv)
+{
+  TestOptions options;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+    {
+      options.filter = argv[++i];
+    }
+    else
+    {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  printf("simd level: %s\n", simdLevelName(simdLevel()));
+  printf("%-36s %-4s %12s\n", "check", "", "max error");
+
+  runMat4(options);
+  runBatch(options);
+  runSoA(options);
+  runPacked(options);
+  runCompressed(options);
+  runBlending(options);
+  runBatchSample(options);
+  runSteadyState(options);
+
+  if (failures > 0)
+  {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  return 0;
+}
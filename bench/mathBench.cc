@@ -0,0 +1,386 @@
+// micro benchmarks for math/, built as its own program by `scons math_bench`.
+//
+//   ./math_bench                   table with ns/op and throughput
+//   ./math_bench --csv             name,count,ns_per_op,mops_per_s lines
+//   ./math_bench --filter quat     only benchmarks whose name contains "quat"
+//   ./math_bench --size 256        a single array size instead of the default
+//   ./math_bench --min-time 200    milliseconds spent per benchmark
+//
+// every benchmark walks arrays of `count` inputs, the sizes below stand for a
+// single skeleton, a small crowd and a large crowd worth of joints.
+
+#include "../math/batch.h"
+#include "../math/mat3x4.h"
+#include "../math/mat4.h"
+#include "../math/packed.h"
+#include "../math/quaternion.h"
+#include "../math/simd.h"
+#include "../math/transform.h"
+#include "../math/transformSoA.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct BenchOptions
+{
+  bool csv = false;
+  std::string filter;
+  std::vector<size_t> sizes = {64, 1024, 16384};
+  double minTime = 100.0;
+};
+
+struct BenchInput
+{
+  std::vector<Mat4x4> mats;
+  std::vector<Mat4x4> otherMats;
+  std::vector<Mat3x4> affines;
+  std::vector<Quat> quats;
+  std::vector<Quat> otherQuats;
+  std::vector<Transform> transforms;
+  std::vector<Transform> otherTransforms;
+  std::vector<float> weights;
+};
+
+// keeps the compiler from dropping results that are never read
+template <typename T>
+static inline void keep(const T &value)
+{
+  asm volatile("" : : "g"(&value) : "memory");
+}
+
+static Transform randomTransform()
+{
+  Transform t;
+  t.translation = Vector3f(random_float(-10, 10), random_float(-10, 10), random_float(-10, 10));
+  t.orientation = Quat(random_float(0, 360), Vector3f(random_float(-1, 1), random_float(-1, 1), random_float(-1, 1) + 2.0f));
+  t.scaling = Vector3f(random_float(1, 2), random_float(1, 2), random_float(1, 2));
+  return t;
+}
+
+static BenchInput makeInput(size_t count)
+{
+  BenchInput in;
+  srand(1234);
+  for (size_t i = 0; i < count; i++)
+  {
+    in.transforms.push_back(randomTransform());
+    in.otherTransforms.push_back(randomTransform());
+    in.mats.push_back(in.transforms.back().get());
+    in.otherMats.push_back(in.otherTransforms.back().get());
+    in.affines.push_back(in.transforms.back().getAffine());
+    in.quats.push_back(in.transforms.back().orientation);
+    in.otherQuats.push_back(in.otherTransforms.back().orientation);
+    in.weights.push_back(random_float());
+  }
+  return in;
+}
+
+/// @brief runs pass until minTime has elapsed, pass handles count operations
+static void run(const BenchOptions &options, const char *name, size_t count, const std::function<void()> &pass)
+{
+  if (!options.filter.empty() && std::string(name).find(options.filter) == std::string::npos)
+  {
+    return;
+  }
+
+  typedef std::chrono::steady_clock Clock;
+
+  // warm up caches and the branch predictor, then double the passes until
+  // the timed run is long enough to trust
+  pass();
+  size_t passes = 1;
+  double elapsed = 0.0;
+  while (true)
+  {
+    Clock::time_point start = Clock::now();
+    for (size_t p = 0; p < passes; p++)
+    {
+      pass();
+    }
+    elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    if (elapsed >= options.minTime * 1e6)
+    {
+      break;
+    }
+    passes *= 2;
+  }
+
+  double nsPerOp = elapsed / (double(passes) * double(count));
+  double mops = 1e3 / nsPerOp;
+
+  if (options.csv)
+  {
+    printf("%s,%zu,%.3f,%.3f\n", name, count, nsPerOp, mops);
+  }
+  else
+  {
+    printf("%-28s %8zu %12.3f %14.3f\n", name, count, nsPerOp, mops);
+  }
+}
+
+static void runAll(const BenchOptions &options, size_t count)
+{
+  BenchInput in = makeInput(count);
+
+  std::vector<Mat4x4> mats(count);
+  std::vector<Mat3x4> affines(count);
+  std::vector<Quat> quats(count);
+  std::vector<Transform> transforms(count);
+
+  // Mat4x4
+  run(options, "mat4_mul", count, [&]()
+      {
+        for (size_t i = 0; i < count; i++)
+        {
+          mats[i] = in.mats[i] * in.otherMats[i];
+        }
+        keep(mats); });
+  for (int level = SimdScalar; level <= simdLevel(); level++)
+  {
+    std::string name = std::string("mat4_mul_batch_") + simdLevelName((SimdLevel)level);
+    const Mat4Kernels &kernels = mat4Kernels((SimdLevel)level);
+    run(options, name.c_str(), count, [&]()
+        {
+          kernels.mulBatch(in.mats.data(), in.otherMats.data(), mats.data(), count);
+          keep(mats); });
+  }
+  run(options, "mat4_transpose", count, [&]()
+      {
+        for (size_t i = 0; i < count; i++)
+        {
+          mats[i] = in.mats[i].transpose();
+        }
+        keep(mats); });
+  run(options, "mat4_inverse_affine", count, [&]()
+      {
+        for (size_t i = 0; i < count; i++)
+        {
+          mats[i] = in.mats[i].inverseAffine();
+        }
+        keep(mats); });
+  run(options, "mat4_to_quat", count, [&]()
+      {
+        for (size_t i = 0; i < count; i++)
+        {
+          quats[i] = in.mats[i].toQuat();
+        }
+        keep(quats); });
+
+  // Mat3x4
+  run(options, "mat3x4_mul", count, [&]()
+      {
+        for (size_t i = 0; i < count; i++)
+        {
+          affines[i] = in.affines[i] * in.affines[count - 1 - i];
+        }
+        keep(affines); });
+
+  // Quat
+  run(options, "quat_mul", count, [&]()
+      {
+        for (size_t i = 0; i < count; i++)
+        {
+          quats[i] = in.quats[i] * in.otherQuats[i];
+        }
+        keep(quats); });
+  run(options, "quat_mix", count, [&]()
+      {
+        for (size_t i = 0; i < count; i++)
+        {
+          quats[i] = mix(in.quats[i], in.otherQuats[i], in.weights[i]);
+        }
+        keep(quats); });
+  run(options, "quat_unit", count, [&]()
+      {
+        for (size_t i = 0; i < count; i++)
+        {
+          quats[i] = (in.quats[i] + in.otherQuats[i]).unit();
+        }
+        keep(quats); });
+  const char *interpNames[] = {"quat_nlerp", "quat_fast_nlerp", "quat_slerp"};
+  for (int mode = QuatNlerp; mode <= QuatSlerp; mode++)
+  {
+    run(options, interpNames[mode], count, [&]()
+        {
+          for (size_t i = 0; i < count; i++)
+          {
+            quats[i] = interpolate(in.quats[i], in.otherQuats[i], in.weights[i], (QuatInterp)mode);
+          }
+          keep(quats); });
+  }
+
+  // packed formats
+  std::vector<Quat48> quat48s(count);
+  std::vector<Quat32> quat32s(count);
+  std::vector<Oct32> octs(count);
+  std::vector<Vector3h> halfs(count);
+  std::vector<Vector3f> vecs(count);
+  run(options, "quat48_pack", count, [&]()
+      {
+        for (size_t i = 0; i < count; i++)
+        {
+          quat48s[i] = Quat48(in.quats[i]);
+        }
+        keep(quat48s); });
+  run(options, "quat48_unpack", count, [&]()
+      {
+        for (size_t i = 0; i < count; i++)
+        {
+          quats[i] = quat48s[i].unpack();
+        }
+        keep(quats); });
+  run(options, "quat32_pack", count, [&]()
+      {
+        for (size_t i = 0; i < count; i++)
+        {
+          quat32s[i] = Quat32(in.quats[i]);
+        }
+        keep(quat32s); });
+  run(options, "quat32_unpack", count, [&]()
+      {
+        for (size_t i = 0; i < count; i++)
+        {
+          quats[i] = quat32s[i].unpack();
+        }
+        keep(quats); });
+  run(options, "oct32_pack", count, [&]()
+      {
+        for (size_t i = 0; i < count; i++)
+        {
+          octs[i] = Oct32(axis(in.quats[i]).unit());
+        }
+        keep(octs); });
+  run(options, "oct32_unpack", count, [&]()
+      {
+        for (size_t i = 0; i < count; i++)
+        {
+          vecs[i] = octs[i].unpack();
+        }
+        keep(vecs); });
+  run(options, "half3_pack", count, [&]()
+      {
+        for (size_t i = 0; i < count; i++)
+        {
+          halfs[i] = Vector3h(in.transforms[i].translation);
+        }
+        keep(halfs); });
+  run(options, "half3_unpack", count, [&]()
+      {
+        for (size_t i = 0; i < count; i++)
+        {
+          vecs[i] = halfs[i].unpack();
+        }
+        keep(vecs); });
+
+  // Transform
+  run(options, "transform_get", count, [&]()
+      {
+        for (size_t i = 0; i < count; i++)
+        {
+          mats[i] = in.transforms[i].get();
+        }
+        keep(mats); });
+  run(options, "transform_get_batch", count, [&]()
+      {
+        getBatch(in.transforms, mats);
+        keep(mats); });
+  run(options, "transform_get_affine_batch", count, [&]()
+      {
+        getBatch(in.transforms, affines);
+        keep(affines); });
+  run(options, "transform_combine", count, [&]()
+      {
+        for (size_t i = 0; i < count; i++)
+        {
+          transforms[i] = combine(in.transforms[i], in.otherTransforms[i]);
+        }
+        keep(transforms); });
+  run(options, "transform_combine_batch", count, [&]()
+      {
+        combineBatch(in.transforms, in.otherTransforms, transforms);
+        keep(transforms); });
+  run(options, "transform_from_mat", count, [&]()
+      {
+        for (size_t i = 0; i < count; i++)
+        {
+          transforms[i] = transformFromMat(in.mats[i]);
+        }
+        keep(transforms); });
+
+  // structure of arrays
+  TransformSoA parents, children, out;
+  parents.load(in.transforms);
+  children.load(in.otherTransforms);
+  run(options, "soa_combine", count, [&]()
+      {
+        combineSoA(parents, children, out);
+        keep(out); });
+  run(options, "soa_get", count, [&]()
+      {
+        getSoA(parents, mats);
+        keep(mats); });
+  run(options, "soa_fast_nlerp", count, [&]()
+      {
+        interpolateSoA(parents, children, in.weights, out, QuatFastNlerp);
+        keep(out); });
+}
+
+static void usage(const char *program)
+{
+  printf("usage: %s [--csv] [--filter name] [--size count] [--min-time ms]\n", program);
+}
+
+int main(int argc, char **argv)
+{
+  BenchOptions options;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--csv") == 0)
+    {
+      options.csv = true;
+    }
+    else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+    {
+      options.filter = argv[++i];
+    }
+    else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+    {
+      options.sizes = {(size_t)atol(argv[++i])};
+    }
+    else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+    {
+      options.minTime = atof(argv[++i]);
+    }
+    else
+    {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (options.csv)
+  {
+    printf("name,count,ns_per_op,mops_per_s\n");
+  }
+  else
+  {
+    printf("simd level: %s\n", simdLevelName(simdLevel()));
+    printf("%-28s %8s %12s %14s\n", "benchmark", "count", "ns/op", "Mops/s");
+  }
+
+  for (size_t count : options.sizes)
+  {
+    if (count > 0)
+    {
+      runAll(options, count);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,216 @@
+#include "batch.h"
+#include "simd.h"
+
+#include <algorithm>
+
+// the loops below are written out component by component, without calls
+// into the per value functions, so the compiler can keep everything in
+// registers and vectorize across joints. results match Transform::get and
+// combine up to float rounding, including for non unit quaternions.
+
+void mulBatch(std::span<const Mat4x4> l, std::span<const Mat4x4> r, std::span<Mat4x4> out)
+{
+  size_t n = std::min({l.size(), r.size(), out.size()});
+  mat4Kernels().mulBatch(l.data(), r.data(), out.data(), n);
+}
+
+void mulBatch(std::span<const Mat3x4> lhs, std::span<const Mat3x4> rhs, std::span<Mat3x4> out)
+{
+  size_t n = std::min({lhs.size(), rhs.size(), out.size()});
+  for (size_t i = 0; i < n; i++)
+  {
+    const Mat3x4 &l = lhs[i];
+    const Mat3x4 &r = rhs[i];
+    out[i] = Mat3x4(
+        M34D(x, x), M34D(x, y), M34D(x, z), M34D(x, w) + l.xw,
+        M34D(y, x), M34D(y, y), M34D(y, z), M34D(y, w) + l.yw,
+        M34D(z, x), M34D(z, y), M34D(z, z), M34D(z, w) + l.zw);
+  }
+}
+
+void mulBatch(std::span<const DualQuat> lhs, std::span<const DualQuat> rhs, std::span<DualQuat> out)
+{
+  size_t n = std::min({lhs.size(), rhs.size(), out.size()});
+  for (size_t i = 0; i < n; i++)
+  {
+    out[i] = lhs[i] * rhs[i];
+  }
+}
+
+// fills the upper three rows of a transform matrix
+static inline void affineRows(const Transform &t, float rc[][4])
+{
+  const float x = t.orientation.x;
+  const float y = t.orientation.y;
+  const float z = t.orientation.z;
+  const float s = t.orientation.s;
+
+  const float xx = x * x, yy = y * y, zz = z * z, ss = s * s;
+  const float xy = x * y, xz = x * z, yz = y * z;
+  const float sx = s * x, sy = s * y, sz = s * z;
+
+  const float sclX = t.scaling.x;
+  const float sclY = t.scaling.y;
+  const float sclZ = t.scaling.z;
+
+  // columns are the rotated and scaled basis vectors
+  rc[0][0] = (ss + xx - yy - zz) * sclX;
+  rc[1][0] = (2.0f * xy + 2.0f * sz) * sclX;
+  rc[2][0] = (2.0f * xz - 2.0f * sy) * sclX;
+
+  rc[0][1] = (2.0f * xy - 2.0f * sz) * sclY;
+  rc[1][1] = (ss - xx + yy - zz) * sclY;
+  rc[2][1] = (2.0f * yz + 2.0f * sx) * sclY;
+
+  rc[0][2] = (2.0f * xz + 2.0f * sy) * sclZ;
+  rc[1][2] = (2.0f * yz - 2.0f * sx) * sclZ;
+  rc[2][2] = (ss - xx - yy + zz) * sclZ;
+
+  rc[0][3] = t.translation.x;
+  rc[1][3] = t.translation.y;
+  rc[2][3] = t.translation.z;
+}
+
+void getBatch(std::span<const Transform> transforms, std::span<Mat4x4> out)
+{
+  size_t n = std::min(transforms.size(), out.size());
+  for (size_t i = 0; i < n; i++)
+  {
+    affineRows(transforms[i], out[i].rc);
+    out[i].rows[3] = Vector4f(0.0f, 0.0f, 0.0f, 1.0f);
+  }
+}
+
+void getBatch(std::span<const Transform> transforms, std::span<Mat3x4> out)
+{
+  size_t n = std::min(transforms.size(), out.size());
+  for (size_t i = 0; i < n; i++)
+  {
+    affineRows(transforms[i], out[i].rc);
+  }
+}
+
+void getBatch(std::span<const Transform> transforms, std::span<DualQuat> out)
+{
+  size_t n = std::min(transforms.size(), out.size());
+  for (size_t i = 0; i < n; i++)
+  {
+    out[i] = dualQuatFromTransform(transforms[i]);
+  }
+}
+
+void combineBatch(std::span<const Transform> parents, std::span<const Transform> children, std::span<Transform> out)
+{
+  size_t n = std::min({parents.size(), children.size(), out.size()});
+  for (size_t i = 0; i < n; i++)
+  {
+    // out may alias the inputs, so every input is read into a plain float
+    // before the first store. (copying whole Transforms instead goes through
+    // the stack and stalls on the partial reloads of the vector unions)
+    const Transform &parent = parents[i];
+    const Transform &child = children[i];
+    const float px = parent.orientation.x, py = parent.orientation.y, pz = parent.orientation.z, ps = parent.orientation.s;
+    const float cx = child.orientation.x, cy = child.orientation.y, cz = child.orientation.z, cs = child.orientation.s;
+    const float tx = parent.translation.x, ty = parent.translation.y, tz = parent.translation.z;
+    const float sx = parent.scaling.x, sy = parent.scaling.y, sz = parent.scaling.z;
+    const float csx = child.scaling.x, csy = child.scaling.y, csz = child.scaling.z;
+
+    // child translation scaled, then rotated by the parent
+    const float vx = sx * child.translation.x;
+    const float vy = sy * child.translation.y;
+    const float vz = sz * child.translation.z;
+
+    const float d = 2.0f * (px * vx + py * vy + pz * vz);
+    const float k = ps * ps - (px * px + py * py + pz * pz);
+    const float s2 = 2.0f * ps;
+
+    // whole members per store, one 16 byte write each
+    Transform &result = out[i];
+    result.scaling = Vector3f(sx * csx, sy * csy, sz * csz);
+    result.translation = Vector3f(tx + px * d + vx * k + (py * vz - pz * vy) * s2,
+                                  ty + py * d + vy * k + (pz * vx - px * vz) * s2,
+                                  tz + pz * d + vz * k + (px * vy - py * vx) * s2);
+    result.orientation = Quat(ps * cx + px * cs + py * cz - pz * cy,
+                              ps * cy + py * cs + pz * cx - px * cz,
+                              ps * cz + pz * cs + px * cy - py * cx,
+                              ps * cs - px * cx - py * cy - pz * cz);
+  }
+}
+
+void normalBatch(std::span<const Mat3x4> palette, std::span<Mat3x3> out)
+{
+  size_t n = std::min(palette.size(), out.size());
+  for (size_t i = 0; i < n; i++)
+  {
+    const Mat3x4 &m = palette[i];
+    Vector3f r0 = Vector3f(m.xx, m.xy, m.xz);
+    Vector3f r1 = Vector3f(m.yx, m.yy, m.yz);
+    Vector3f r2 = Vector3f(m.zx, m.zy, m.zz);
+
+    // the inverse has the cross products of the rows as columns, so they are
+    // the rows of the inverse transpose
+    Vector3f c0 = cross(r1, r2);
+    Vector3f c1 = cross(r2, r0);
+    Vector3f c2 = cross(r0, r1);
+    float invDet = 1.0f / dot(r0, c0);
+    // element wise, Mat3x3's rows are padded Vector3f and do not line up with
+    // the packed rc elements the shaders are given
+    out[i] = Mat3x3(c0.x * invDet, c0.y * invDet, c0.z * invDet,
+                    c1.x * invDet, c1.y * invDet, c1.z * invDet,
+                    c2.x * invDet, c2.y * invDet, c2.z * invDet);
+  }
+}
+
+bool isRigidBatch(std::span<const Mat3x4> palette, float tolerance)
+{
+  for (const Mat3x4 &m : palette)
+  {
+    // columns are the scaled basis vectors, they have to be orthogonal and
+    // of one length
+    Vector3f x = Vector3f(m.xx, m.yx, m.zx);
+    Vector3f y = Vector3f(m.xy, m.yy, m.zy);
+    Vector3f z = Vector3f(m.xz, m.yz, m.zz);
+
+    float lenSqrd = x.magSqrd();
+    float bound = tolerance * lenSqrd;
+    if (fabsf(y.magSqrd() - lenSqrd) > bound || fabsf(z.magSqrd() - lenSqrd) > bound ||
+        fabsf(dot(x, y)) > bound || fabsf(dot(y, z)) > bound || fabsf(dot(z, x)) > bound)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+void lerpBatch(std::span<const Mat3x4> a, std::span<const Mat3x4> b, float t, std::span<Mat3x4> out)
+{
+  size_t n = std::min({a.size(), b.size(), out.size()});
+  for (size_t i = 0; i < n; i++)
+  {
+    for (size_t r = 0; r < 3; r++)
+    {
+      for (size_t c = 0; c < 4; c++)
+      {
+        out[i].rc[r][c] = a[i].rc[r][c] + (b[i].rc[r][c] - a[i].rc[r][c]) * t;
+      }
+    }
+  }
+}
+
+void lerpBatch(std::span<const DualQuat> a, std::span<const DualQuat> b, float t, std::span<DualQuat> out)
+{
+  size_t n = std::min({a.size(), b.size(), out.size()});
+  for (size_t i = 0; i < n; i++)
+  {
+    const DualQuat &from = a[i];
+    const DualQuat &to = b[i];
+    float s = dot(from.real, to.real) < 0.0f ? -t : t;
+    DualQuat result;
+    for (size_t k = 0; k < 4; k++)
+    {
+      result.real.v[k] = from.real.v[k] * (1.0f - t) + to.real.v[k] * s;
+      result.dual.v[k] = from.dual.v[k] * (1.0f - t) + to.dual.v[k] * s;
+    }
+    out[i] = result;
+  }
+}
@@ -0,0 +1,46 @@
+#ifndef MATH_BATCH_H
+#define MATH_BATCH_H
+
+#include "dualQuat.h"
+#include "mat3.h"
+#include "mat3x4.h"
+#include "mat4.h"
+#include "transform.h"
+
+#include <span>
+
+// array versions of the per value math functions, meant for whole skeletons
+// at once. every output span has to be as long as its inputs, outputs may
+// alias the inputs.
+
+/// @brief out[i] = l[i] * r[i]
+void mulBatch(std::span<const Mat4x4> l, std::span<const Mat4x4> r, std::span<Mat4x4> out);
+void mulBatch(std::span<const Mat3x4> l, std::span<const Mat3x4> r, std::span<Mat3x4> out);
+void mulBatch(std::span<const DualQuat> l, std::span<const DualQuat> r, std::span<DualQuat> out);
+
+/// @brief out[i] = transforms[i].get(), or getAffine() for 3x4 outputs, or
+/// dualQuatFromTransform(transforms[i]) for dual quaternion outputs
+void getBatch(std::span<const Transform> transforms, std::span<Mat4x4> out);
+void getBatch(std::span<const Transform> transforms, std::span<Mat3x4> out);
+void getBatch(std::span<const Transform> transforms, std::span<DualQuat> out);
+
+/// @brief out[i] = combine(parents[i], children[i])
+void combineBatch(std::span<const Transform> parents, std::span<const Transform> children, std::span<Transform> out);
+
+/// @brief out[i] = inverse transpose of the upper 3x3 block of palette[i],
+/// the matrix that carries normals through palette[i]
+void normalBatch(std::span<const Mat3x4> palette, std::span<Mat3x3> out);
+
+/// @brief out[i] = a[i] + (b[i] - a[i]) * t per element. close to blending
+/// the transforms only while a[i] and b[i] are close, like skin palettes a
+/// fraction of a second apart. dual quaternions are taken the short way
+/// round and not normalized, skinning normalizes the blend anyway
+void lerpBatch(std::span<const Mat3x4> a, std::span<const Mat3x4> b, float t, std::span<Mat3x4> out);
+void lerpBatch(std::span<const DualQuat> a, std::span<const DualQuat> b, float t, std::span<DualQuat> out);
+
+/// @brief true when every matrix is a rotation times a uniform scale. the
+/// upper 3x3 block is then its own normal matrix up to length and
+/// normalBatch can be skipped
+bool isRigidBatch(std::span<const Mat3x4> palette, float tolerance = 0.001f);
+
+#endif
@@ -0,0 +1,27 @@
+#include "dualQuat.h"
+
+// DualQuat is header defined and constexpr, checked against Transform here
+
+namespace
+{
+  constexpr Transform rigid()
+  {
+    Transform t = Transform();
+    t.orientation = Quat(90.0f, Vector3f(0.0f, 0.0f, 1.0f));
+    t.translation = Vector3f(1.0f, 2.0f, 3.0f);
+    return t;
+  }
+
+  constexpr bool near(const Vector3f &l, const Vector3f &r) { return (l - r).mag() < 0.00001f; }
+}
+
+static_assert(near(dualQuatFromTransform(rigid()).transformPoint(Vector3f(1.0f, 0.0f, 0.0f)),
+                   rigid().getAffine().transformPoint(Vector3f(1.0f, 0.0f, 0.0f))));
+static_assert(near(dualQuatFromTransform(rigid()).translation(), rigid().translation));
+static_assert(near((dualQuatFromTransform(rigid()) * dualQuatFromTransform(rigid())).transformPoint(Vector3f(1.0f)),
+                   combine(rigid(), rigid()).getAffine().transformPoint(Vector3f(1.0f))));
+static_assert((2.0f * dualQuatFromTransform(rigid())).unit() == dualQuatFromTransform(rigid()));
+static_assert(DualQuat() * dualQuatFromTransform(rigid()) == dualQuatFromTransform(rigid()));
+
+// Shader::updateDualQuat uploads real and dual as one block of 8 floats
+static_assert(sizeof(DualQuat) == 8 * sizeof(float));
@@ -0,0 +1,89 @@
+#ifndef DUAL_QUATERNION_H
+#define DUAL_QUATERNION_H
+
+#include "quaternion.h"
+#include "transform.h"
+#include "vec3.h"
+
+/// @brief rigid transform (rotation + translation) stored as real + e * dual
+/// quaternion. 8 floats instead of the 12 of a Mat3x4, and blending a few of
+/// them keeps the volume that linear matrix blending collapses at twisted
+/// joints. scaling is not representable and gets dropped.
+struct DualQuat
+{
+  Quat real;
+  Quat dual;
+
+  constexpr DualQuat() : real(Quat()), dual(Quat(0.0f)) {}
+  constexpr DualQuat(Quat _real, Quat _dual) : real(_real), dual(_dual) {}
+
+  /// @brief rotation followed by translation
+  /// @param 1: orientation, expected to be unit length
+  /// @param 2: translation
+  constexpr DualQuat(Quat rotation, Vector3f translation)
+      : real(rotation),
+        dual(0.5f * (Quat(translation.x, translation.y, translation.z, 0.0f) * rotation)) {}
+
+  constexpr Vector3f translation() const
+  {
+    Quat t = 2.0f * (this->dual * this->real.conjugate());
+    return Vector3f(t.x, t.y, t.z);
+  }
+  constexpr Quat rotation() const { return this->real; }
+
+  /// @brief divides both parts by the length of the real part, needed after
+  /// blending to get a rigid transform back
+  constexpr DualQuat unit() const
+  {
+    float coeff = 1.0f / this->real.norm();
+    return DualQuat(this->real * coeff, this->dual * coeff);
+  }
+  constexpr DualQuat conjugate() const { return DualQuat(this->real.conjugate(), this->dual.conjugate()); }
+
+  constexpr Vector3f transformPoint(const Vector3f &p) const { return this->real * p + this->translation(); }
+  constexpr Vector3f transformVector(const Vector3f &v) const { return this->real * v; }
+
+  constexpr Transform toTransform() const
+  {
+    Transform result = Transform();
+    result.orientation = this->real;
+    result.translation = this->translation();
+    return result;
+  }
+};
+
+/// @brief rotation and translation of a transform, its scaling is ignored
+constexpr DualQuat dualQuatFromTransform(const Transform &t)
+{
+  return DualQuat(t.orientation, t.translation);
+}
+
+// operator overloads
+//________________________________________________________________________
+//________________________________________________________________________
+
+constexpr DualQuat operator+(const DualQuat &lhs, const DualQuat &rhs)
+{
+  return DualQuat(lhs.real + rhs.real, lhs.dual + rhs.dual);
+}
+
+constexpr DualQuat operator*(float lhs, const DualQuat &rhs) { return DualQuat(lhs * rhs.real, lhs * rhs.dual); }
+constexpr DualQuat operator*(const DualQuat &lhs, float rhs) { return rhs * lhs; }
+
+/// @brief composition, applies rhs first like Mat4x4 multiplication
+constexpr DualQuat operator*(const DualQuat &lhs, const DualQuat &rhs)
+{
+  return DualQuat(
+      lhs.real * rhs.real,
+      lhs.real * rhs.dual + lhs.dual * rhs.real);
+}
+
+constexpr bool operator==(const DualQuat &lhs, const DualQuat &rhs)
+{
+  return lhs.real == rhs.real && lhs.dual == rhs.dual;
+}
+constexpr bool operator!=(const DualQuat &lhs, const DualQuat &rhs) { return !(lhs == rhs); }
+
+constexpr float dot(const DualQuat &lhs, const DualQuat &rhs) { return dot(lhs.real, rhs.real); }
+
+#endif
@@ -0,0 +1,10 @@
+#include "mat3x4.h"
+
+// Mat3x4 is header defined and constexpr, checked against Mat4x4 here
+
+static_assert((Mat3x4(translate(Vector3f(1.0f))) * Mat3x4(scale(Vector3f(2.0f)))).toMat4x4() ==
+              translate(Vector3f(1.0f)) * scale(Vector3f(2.0f)));
+static_assert(Mat3x4(scale(Vector3f(2.0f)) * translate(Vector3f(1.0f))).inverse().toMat4x4() ==
+              (scale(Vector3f(2.0f)) * translate(Vector3f(1.0f))).inverseAffine());
+static_assert(Mat3x4(translate(Vector3f(1.0f))).transformPoint(Vector3f(1.0f)) == Vector3f(2.0f));
+static_assert(Mat3x4(translate(Vector3f(1.0f))).transformVector(Vector3f(1.0f)) == Vector3f(1.0f));
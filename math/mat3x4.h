@@ -0,0 +1,135 @@
+#ifndef MATRIX3x4_H
+#define MATRIX3x4_H
+
+#include "mat4.h"
+#include "vec3.h"
+#include "vec4.h"
+
+// for multiplication of two 3x4 mats, the implicit 0 0 0 1 row of the right
+// hand side drops a quarter of the products of a 4x4 multiply. rows and
+// columns are given by their letter like M4D
+#define M34D(aRow, bCol)                \
+      l.aRow##x * r.x##bCol +           \
+      l.aRow##y * r.y##bCol +           \
+      l.aRow##z * r.z##bCol
+
+/// @brief affine transform, the upper three rows of a Mat4x4 whose last row
+/// is always 0 0 0 1. same row-major layout as Mat4x4 with that row dropped.
+struct Mat3x4
+{
+  union
+  {
+    struct
+    {
+      //        column 1  column 2  column 3  column 4
+      /*row 1*/ float xx; float xy; float xz; float xw;
+      /*row 2*/ float yx; float yy; float yz; float yw;
+      /*row 3*/ float zx; float zy; float zz; float zw;
+    };
+    Vector4f rows[3];
+    float rc[3][4];
+  };
+
+  constexpr Mat3x4()
+      : xx(0.0f), xy(0.0f), xz(0.0f), xw(0.0f),
+        yx(0.0f), yy(0.0f), yz(0.0f), yw(0.0f),
+        zx(0.0f), zy(0.0f), zz(0.0f), zw(0.0f) {}
+
+  constexpr Mat3x4(
+      float _00, float _01, float _02, float _03,
+      float _10, float _11, float _12, float _13,
+      float _20, float _21, float _22, float _23)
+      : xx(_00), xy(_01), xz(_02), xw(_03),
+        yx(_10), yy(_11), yz(_12), yw(_13),
+        zx(_20), zy(_21), zz(_22), zw(_23) {}
+
+  constexpr Mat3x4(
+      Vector4f row1,
+      Vector4f row2,
+      Vector4f row3)
+      : xx(row1.x), xy(row1.y), xz(row1.z), xw(row1.w),
+        yx(row2.x), yy(row2.y), yz(row2.z), yw(row2.w),
+        zx(row3.x), zy(row3.y), zz(row3.z), zw(row3.w) {}
+
+  /// @brief drops the last row of a 4x4 matrix, only valid for affine ones
+  constexpr explicit Mat3x4(const Mat4x4 &m)
+      : xx(m.xx), xy(m.xy), xz(m.xz), xw(m.xw),
+        yx(m.yx), yy(m.yy), yz(m.yz), yw(m.yw),
+        zx(m.zx), zy(m.zy), zz(m.zz), zw(m.zw) {}
+
+  constexpr Mat4x4 toMat4x4() const
+  {
+    return Mat4x4(
+        this->xx, this->xy, this->xz, this->xw,
+        this->yx, this->yy, this->yz, this->yw,
+        this->zx, this->zy, this->zz, this->zw,
+        0.0f, 0.0f, 0.0f, 1.0f);
+  }
+
+  /// @brief inverse of the affine transform
+  /// @return
+  constexpr Mat3x4 inverse() const
+  {
+    Vector3f r0 = Vector3f(this->xx, this->xy, this->xz);
+    Vector3f r1 = Vector3f(this->yx, this->yy, this->yz);
+    Vector3f r2 = Vector3f(this->zx, this->zy, this->zz);
+
+    // the columns of the inverted 3x3 block are the cross products of its rows
+    float invDet = 1.0f / dot(r0, cross(r1, r2));
+    Vector3f c0 = cross(r1, r2) * invDet;
+    Vector3f c1 = cross(r2, r0) * invDet;
+    Vector3f c2 = cross(r0, r1) * invDet;
+
+    Vector3f t = -1.0f * (c0 * this->xw + c1 * this->yw + c2 * this->zw);
+
+    return Mat3x4(
+        c0.x, c1.x, c2.x, t.x,
+        c0.y, c1.y, c2.y, t.y,
+        c0.z, c1.z, c2.z, t.z);
+  }
+
+  /// @brief applies rotation, scale and translation
+  constexpr Vector3f transformPoint(const Vector3f &p) const
+  {
+    return Vector3f(
+        this->xx * p.x + this->xy * p.y + this->xz * p.z + this->xw,
+        this->yx * p.x + this->yy * p.y + this->yz * p.z + this->yw,
+        this->zx * p.x + this->zy * p.y + this->zz * p.z + this->zw);
+  }
+  /// @brief applies rotation and scale only
+  constexpr Vector3f transformVector(const Vector3f &v) const
+  {
+    return Vector3f(
+        this->xx * v.x + this->xy * v.y + this->xz * v.z,
+        this->yx * v.x + this->yy * v.y + this->yz * v.z,
+        this->zx * v.x + this->zy * v.y + this->zz * v.z);
+  }
+};
+
+constexpr Mat3x4 identity3x4()
+{
+  return Mat3x4(
+      1.0, 0.0, 0.0, 0.0,
+      0.0, 1.0, 0.0, 0.0,
+      0.0, 0.0, 1.0, 0.0);
+}
+
+/// @brief composition of two affine transforms, same as multiplying the
+/// equivalent 4x4 matrices
+constexpr Mat3x4 operator*(const Mat3x4 &l, const Mat3x4 &r)
+{
+  return Mat3x4(
+      M34D(x, x), M34D(x, y), M34D(x, z), M34D(x, w) + l.xw,
+      M34D(y, x), M34D(y, y), M34D(y, z), M34D(y, w) + l.yw,
+      M34D(z, x), M34D(z, y), M34D(z, z), M34D(z, w) + l.zw);
+}
+
+constexpr bool operator==(const Mat3x4 &l, const Mat3x4 &r)
+{
+  return l.xx == r.xx && l.xy == r.xy && l.xz == r.xz && l.xw == r.xw &&
+         l.yx == r.yx && l.yy == r.yy && l.yz == r.yz && l.yw == r.yw &&
+         l.zx == r.zx && l.zy == r.zy && l.zz == r.zz && l.zw == r.zw;
+}
+constexpr bool operator!=(const Mat3x4 &l, const Mat3x4 &r) { return !(l == r); }
+
+#endif
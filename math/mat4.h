@@ -5,13 +5,17 @@
 #include "vec3.h"
 #include "vec4.h"
 
-// for multiplication of two 4x4 mats
-#define M4D(aRow, bCol)               \
-      l.rc[aRow][0] * r.rc[0][bCol] + \
-      l.rc[aRow][1] * r.rc[1][bCol] + \
-      l.rc[aRow][2] * r.rc[2][bCol] + \
-      l.rc[aRow][3] * r.rc[3][bCol]
+// for multiplication of two 4x4 mats, rows and columns are given by their
+// letter: M4D(y, z) is row 2 of l times column 3 of r
+#define M4D(aRow, bCol)                 \
+      l.aRow##x * r.x##bCol +           \
+      l.aRow##y * r.y##bCol +           \
+      l.aRow##z * r.z##bCol +           \
+      l.aRow##w * r.w##bCol
 
+// everything except toQuat is header defined and constexpr. constexpr code
+// has to stick to the named members (xx, xy, ...) since those are the active
+// members of the unions at compile time.
 struct Mat4x4
 {
   union
@@ -29,19 +33,19 @@ struct Mat4x4
   };
   // default constructor
   // set identity matrix
-  Mat4x4()
+  constexpr Mat4x4()
       : xx(0.0f), xy(0.0f), xz(0.0f), xw(0.0f),
         yx(0.0f), yy(0.0f), yz(0.0f), yw(0.0f),
         zx(0.0f), zy(0.0f), zz(0.0f), zw(0.0f),
         wx(0.0f), wy(0.0f), wz(0.0f), ww(0.0f) {}
   // construct matrix using an array
-  Mat4x4(const float *fv)
+  constexpr Mat4x4(const float *fv)
       : xx(fv[0]), xy(fv[1]), xz(fv[2]), xw(fv[3]),
         yx(fv[4]), yy(fv[5]), yz(fv[6]), yw(fv[7]),
         zx(fv[8]), zy(fv[9]), zz(fv[10]), zw(fv[11]),
         wx(fv[12]), wy(fv[13]), wz(fv[14]), ww(fv[15]) {}
 
-  Mat4x4(
+  constexpr Mat4x4(
       float _00, float _01, float _02, float _03,
       float _10, float _11, float _12, float _13,
       float _20, float _21, float _22, float _23,
@@ -51,52 +55,200 @@ struct Mat4x4
         zx(_20), zy(_21), zz(_22), zw(_23),
         wx(_30), wy(_31), wz(_32), ww(_33) {}
 
-  Mat4x4(
+  constexpr Mat4x4(
       Vector4f row1,
       Vector4f row2,
       Vector4f row3,
       Vector4f row4)
-      : rows{row1, row2, row3, row4} {}
+      : xx(row1.x), xy(row1.y), xz(row1.z), xw(row1.w),
+        yx(row2.x), yy(row2.y), yz(row2.z), yw(row2.w),
+        zx(row3.x), zy(row3.y), zz(row3.z), zw(row3.w),
+        wx(row4.x), wy(row4.y), wz(row4.z), ww(row4.w) {}
 
   struct Quat toQuat() const;
   /// @brief from a row-major matrix to a column-major and vice versa
   /// @return 
-  Mat4x4 transpose() const;
+  constexpr Mat4x4 transpose() const;
+  /// @brief inverse of a matrix whose last row is 0 0 0 1, cheaper than a
+  /// general 4x4 inverse
+  /// @return
+  constexpr Mat4x4 inverseAffine() const;
 };
 
+// scalar implementations behind the per value operators, inline so single
+// operations compile to straight line code. the simd kernels in simd.cc only
+// serve the batch apis (mat4Kernels, mulBatch) and have to match these
+constexpr Mat4x4 mat4MulScalar(const Mat4x4 &l, const Mat4x4 &r)
+{
+  return Mat4x4(
+      M4D(x, x), M4D(x, y), M4D(x, z), M4D(x, w),
+      M4D(y, x), M4D(y, y), M4D(y, z), M4D(y, w),
+      M4D(z, x), M4D(z, y), M4D(z, z), M4D(z, w),
+      M4D(w, x), M4D(w, y), M4D(w, z), M4D(w, w));
+}
+
+constexpr Vector4f mat4MulVecScalar(const Mat4x4 &m, const Vector4f &v)
+{
+  return Vector4f(
+      m.xx * v.x + m.xy * v.y + m.xz * v.z + m.xw * v.w,
+      m.yx * v.x + m.yy * v.y + m.yz * v.z + m.yw * v.w,
+      m.zx * v.x + m.zy * v.y + m.zz * v.z + m.zw * v.w,
+      m.wx * v.x + m.wy * v.y + m.wz * v.z + m.ww * v.w);
+}
+
+constexpr Mat4x4 mat4TransposeScalar(const Mat4x4 &m)
+{
+  return Mat4x4(
+      m.xx, m.yx, m.zx, m.wx,
+      m.xy, m.yy, m.zy, m.wy,
+      m.xz, m.yz, m.zz, m.wz,
+      m.xw, m.yw, m.zw, m.ww);
+}
+
+constexpr Mat4x4 mat4InverseAffineScalar(const Mat4x4 &m)
+{
+  // the columns of the inverted 3x3 block are the cross products of its
+  // rows. plain floats, Vector3f temporaries keep it from staying in
+  // registers once inlined
+  float c0x = m.yy * m.zz - m.yz * m.zy;
+  float c0y = m.yz * m.zx - m.yx * m.zz;
+  float c0z = m.yx * m.zy - m.yy * m.zx;
+  float c1x = m.zy * m.xz - m.zz * m.xy;
+  float c1y = m.zz * m.xx - m.zx * m.xz;
+  float c1z = m.zx * m.xy - m.zy * m.xx;
+  float c2x = m.xy * m.yz - m.xz * m.yy;
+  float c2y = m.xz * m.yx - m.xx * m.yz;
+  float c2z = m.xx * m.yy - m.xy * m.yx;
+
+  float invDet = 1.0f / (m.xx * c0x + m.xy * c0y + m.xz * c0z);
+  c0x *= invDet, c0y *= invDet, c0z *= invDet;
+  c1x *= invDet, c1y *= invDet, c1z *= invDet;
+  c2x *= invDet, c2y *= invDet, c2z *= invDet;
+
+  return Mat4x4(
+      c0x, c1x, c2x, -(c0x * m.xw + c1x * m.yw + c2x * m.zw),
+      c0y, c1y, c2y, -(c0y * m.xw + c1y * m.yw + c2y * m.zw),
+      c0z, c1z, c2z, -(c0z * m.xw + c1z * m.yw + c2z * m.zw),
+      0.0f, 0.0f, 0.0f, 1.0f);
+}
 
-Mat4x4 identity();
+constexpr Mat4x4 Mat4x4::transpose() const { return mat4TransposeScalar(*this); }
+constexpr Mat4x4 Mat4x4::inverseAffine() const { return mat4InverseAffineScalar(*this); }
+
+constexpr Mat4x4 identity()
+{
+  return Mat4x4(
+      1.0, 0.0, 0.0, 0.0,
+      0.0, 1.0, 0.0, 0.0,
+      0.0, 0.0, 1.0, 0.0,
+      0.0, 0.0, 0.0, 1.0);
+}
 /// @brief create a translation matrix out of a vec3
 /// @param t translation vector
 /// @return translation mat
-Mat4x4 translate(const Vector3f t);
+constexpr Mat4x4 translate(const Vector3f t)
+{
+  Mat4x4 trans = identity();
+  trans.xw = t.x;
+  trans.yw = t.y;
+  trans.zw = t.z;
+  return trans;
+}
 
 /// @brief create a scaling matrix out of a vec3
 /// @param s scaling vector
 /// @return scaling matrix
-Mat4x4 scale(const Vector3f s);
+constexpr Mat4x4 scale(const Vector3f s)
+{
+  Mat4x4 trans = identity();
+  trans.xx = s.x;
+  trans.yy = s.y;
+  trans.zz = s.z;
+  return trans;
+}
 
 /// @brief create a rotation matrix for the X axis
 /// @param angle rotational angle
 /// @return rotation mat for the x axis
-Mat4x4 rotationX(float angle);
+constexpr Mat4x4 rotationX(float angle)
+{
+  Mat4x4 trans;
+  float rads = to_radians(angle);
+  trans.xx = 1.0f;
+  trans.yy = cx_cos(rads);
+  trans.yz = -cx_sin(rads);
+  trans.zy = cx_sin(rads);
+  trans.zz = cx_cos(rads);
+  trans.ww = 1.0f;
+  return trans;
+}
 
 /// @brief create a rotation matrix for the Y axis
 /// @param angle rotational angle
 /// @return rotation mat for the y axis
-Mat4x4 rotationY(float angle);
+constexpr Mat4x4 rotationY(float angle)
+{
+  Mat4x4 trans;
+  float rads = to_radians(angle);
+  trans.xx = cx_cos(rads);
+  trans.xz = cx_sin(rads);
+  trans.yy = 1.0f;
+  trans.zx = -cx_sin(rads);
+  trans.zz = cx_cos(rads);
+  trans.ww = 1.0f;
+  return trans;
+}
 
 /// @brief create a rotation matrix for the Z axis
 /// @param angle rotational angle
 /// @return rotation mat for the z axis
-Mat4x4 rotationZ(float angle);
+constexpr Mat4x4 rotationZ(float angle)
+{
+  Mat4x4 trans;
+  float rads = to_radians(angle);
+  trans.xx = cx_cos(rads);
+  trans.xy = cx_sin(rads);
+  trans.yx = -cx_sin(rads);
+  trans.yy = cx_cos(rads);
+  trans.zz = 1.0f;
+  trans.ww = 1.0f;
+  return trans;
+}
 
 /// @brief create a view matrix from camera rotation
 /// @param pos camera pos
 /// @param dir camera direction
 /// @param up camera upwards direction
 /// @return rotation matrix for the world relative to camera
-Mat4x4 look_at(const Vector3f &pos, const Vector3f &dir, const Vector3f &up);
+constexpr Mat4x4 look_at(const Vector3f &pos, const Vector3f &fr, const Vector3f &up)
+{
+  // cr = camera right vector
+  Vector3f cd = (pos - fr).unit();
+  Vector3f cr = (cross(up, cd)).unit();
+  Vector3f cu = (cross(cd, cr)).unit();
+
+  // rotation and translation matrix combined
+  float xx = cr.x;
+  float xy = cr.y;
+  float xz = cr.z;
+  float xw = -pos.x * cr.x - pos.y * cr.y - pos.z * cr.z;
+
+  float yx = cu.x;
+  float yy = cu.y;
+  float yz = cu.z;
+  float yw = -pos.x * cu.x - pos.y * cu.y - pos.z * cu.z;
+
+  float zx = cd.x;
+  float zy = cd.y;
+  float zz = cd.z;
+  float zw = -pos.x * cd.x - pos.y * cd.y - pos.z * cd.z;
+
+  return Mat4x4(
+      xx, xy, xz, xw,
+      yx, yy, yz, yw,
+      zx, zy, zz, zw,
+      0.0, 0.0, 0.0, 1.0);
+}
 
 /// @brief for creating an orthogonal projection matrix using dimentions
 /// @param l left
@@ -106,7 +258,33 @@ Mat4x4 look_at(const Vector3f &pos, const Vector3f &dir, const Vector3f &up);
 /// @param n near
 /// @param f far
 /// @return projection mat
-Mat4x4 orthogonal(float l, float r, float b, float t, float n = -1.0f, float f = 1.0f);
+constexpr Mat4x4 orthogonal(float l, float r, float b, float t, float n = -1.0f, float f = 1.0f)
+{
+  Mat4x4 proj;
+  proj.xx = 2.0f / (r - l);
+  proj.xw = -((r + l) / (r - l));
+  proj.yy = 2.0f / (t - b);
+  proj.yw = -((t + b) / (t - b));
+  proj.zz = -2.0f / (f - n);
+  proj.zw = -((f + n) / (f - n));
+  proj.ww = 1.0f;
+
+  return proj;
+}
+
+constexpr Mat4x4 frustrum(float l, float r, float b, float t, float n, float f)
+{
+  Mat4x4 proj;
+  proj.xx = (2.0f * n) / (r - l);
+  proj.xz = (r + l) / (r - l);
+  proj.yy = (2.0f * n) / (t - b);
+  proj.yz = (t + b) / (t - b);
+  proj.zz = -(f + n) / (f - n);
+  proj.zw = (-2.0f * f * n) / (f - n);
+  proj.wz = -1.0f;
+  proj.ww = 0.0f;
+  return proj;
+}
 
 /// @brief for creating a perspective projection
 /// @param fov field of view
@@ -114,20 +292,54 @@ Mat4x4 orthogonal(float l, float r, float b, float t, float n = -1.0f, float f =
 /// @param N near 
 /// @param F far
 /// @return perspective mat
-Mat4x4 perspective(float fov, float aspectRation, float N, float F);
-Mat4x4 frustrum(float l, float r, float t, float b, float n, float f);
+constexpr Mat4x4 perspective(float fov, float aspectRatio, float N, float F)
+{
+
+  float ymax = N * cx_tan((to_radians(fov / 2.0f)));
+  float xmax = ymax * aspectRatio;
+
+  return frustrum(-xmax, xmax, -ymax, ymax, N, F);
+}
 
 // multiplication operations
-Mat4x4 operator*(const Mat4x4 &l, float r);
-Mat4x4 operator*(float l, const Mat4x4 &r);
-Mat4x4 operator*(const Mat4x4 &l, const Mat4x4 &r);
-Vector4f operator*(const Mat4x4 &m, const Vector4f &v);
+constexpr Mat4x4 operator*(const Mat4x4 &l, float r)
+{
+  return Mat4x4(
+      l.xx * r, l.xy * r, l.xz * r, l.xw * r,
+      l.yx * r, l.yy * r, l.yz * r, l.yw * r,
+      l.zx * r, l.zy * r, l.zz * r, l.zw * r,
+      l.wx * r, l.wy * r, l.wz * r, l.ww * r);
+}
+constexpr Mat4x4 operator*(float l, const Mat4x4 &r) { return r * l; }
+
+constexpr Mat4x4 operator*(const Mat4x4 &l, const Mat4x4 &r) { return mat4MulScalar(l, r); }
+constexpr Vector4f operator*(const Mat4x4 &m, const Vector4f &v) { return mat4MulVecScalar(m, v); }
 // addition operations
-Mat4x4 operator+(const Mat4x4 &l, const Mat4x4 &r);
+constexpr Mat4x4 operator+(const Mat4x4 &l, const Mat4x4 &r)
+{
+  return Mat4x4(
+      l.xx + r.xx, l.xy + r.xy, l.xz + r.xz, l.xw + r.xw,
+      l.yx + r.yx, l.yy + r.yy, l.yz + r.yz, l.yw + r.yw,
+      l.zx + r.zx, l.zy + r.zy, l.zz + r.zz, l.zw + r.zw,
+      l.wx + r.wx, l.wy + r.wy, l.wz + r.wz, l.ww + r.ww);
+}
 // sutraction operations
-Mat4x4 operator-(const Mat4x4 &l, const Mat4x4 &r);
+constexpr Mat4x4 operator-(const Mat4x4 &l, const Mat4x4 &r)
+{
+  return Mat4x4(
+      l.xx - r.xx, l.xy - r.xy, l.xz - r.xz, l.xw - r.xw,
+      l.yx - r.yx, l.yy - r.yy, l.yz - r.yz, l.yw - r.yw,
+      l.zx - r.zx, l.zy - r.zy, l.zz - r.zz, l.zw - r.zw,
+      l.wx - r.wx, l.wy - r.wy, l.wz - r.wz, l.ww - r.ww);
+}
 // comparison operations
-bool operator==(const Mat4x4 &m1, const Mat4x4 &m2);
-bool operator!=(const Mat4x4 &m1, const Mat4x4 &m2);
+constexpr bool operator==(const Mat4x4 &l, const Mat4x4 &r)
+{
+  return l.xx == r.xx && l.xy == r.xy && l.xz == r.xz && l.xw == r.xw &&
+         l.yx == r.yx && l.yy == r.yy && l.yz == r.yz && l.yw == r.yw &&
+         l.zx == r.zx && l.zy == r.zy && l.zz == r.zz && l.zw == r.zw &&
+         l.wx == r.wx && l.wy == r.wy && l.wz == r.wz && l.ww == r.ww;
+}
+constexpr bool operator!=(const Mat4x4 &l, const Mat4x4 &r) { return !(l == r); }
 
 #endif
\ No newline at end of file
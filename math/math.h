@@ -3,5 +3,8 @@
 #include "vec4.h"
 #include "mat3.h"
 #include "mat4.h"
+#include "mat3x4.h"
 #include "quaternion.h"
+#include "dualQuat.h"
 #include "transform.h"
+#include "packed.h"
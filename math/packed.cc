@@ -0,0 +1,18 @@
+#include "packed.h"
+
+// the packed types are header defined and constexpr, checked here
+
+static_assert(sizeof(Quat48) == 6 && sizeof(Quat32) == 4);
+static_assert(sizeof(Oct16) == 2 && sizeof(Oct32) == 4);
+static_assert(sizeof(Vector3h) == 6 && sizeof(Vector4h) == 8);
+
+static_assert(Quat48().unpack() == Quat() && Quat32().unpack() == Quat());
+static_assert(Quat48(Quat(0.0f, 0.0f, 0.0f, -1.0f)).unpack() == Quat());
+static_assert(cx_fabs(dot(Quat48(Quat(0.5f, -0.5f, 0.5f, 0.5f)).unpack(), Quat(0.5f, -0.5f, 0.5f, 0.5f))) > 0.99999f);
+
+static_assert(Oct32(Vector3f(0.0f, 0.0f, -1.0f)).unpack() == Vector3f(0.0f, 0.0f, -1.0f));
+static_assert(Oct16(Vector3f(1.0f, 0.0f, 0.0f)).unpack() == Vector3f(1.0f, 0.0f, 0.0f));
+
+static_assert(halfToFloat(floatToHalf(1.0f)) == 1.0f && halfToFloat(floatToHalf(-2.5f)) == -2.5f);
+static_assert(floatToHalf(65504.0f) == 0x7bff && floatToHalf(1.0e6f) == 0x7c00);
+static_assert(halfToFloat(0x0001) == 5.9604645e-8f);
@@ -0,0 +1,326 @@
+#ifndef MATH_PACKED_H
+#define MATH_PACKED_H
+
+#include "quaternion.h"
+#include "utils.h"
+#include "vec3.h"
+#include "vec4.h"
+
+#include <bit>
+#include <stdint.h>
+
+// compact storage formats for rotations, unit vectors and plain vectors.
+// everything is header defined and constexpr. the error bounds below are the
+// worst cases measured over millions of random unit inputs plus the axes.
+
+// half floats
+//________________________________________________________________________
+//________________________________________________________________________
+
+/// @brief float to ieee 754 binary16, rounded to nearest even. values past
+/// the half range become infinity, nan stays nan. relative error 2^-11
+/// (4.9e-4) in the normal range [6.1e-5, 65504]
+constexpr uint16_t floatToHalf(float value)
+{
+  const uint32_t infinity = 255u << 23;
+  const uint32_t halfMax = (127u + 16u) << 23;
+  const uint32_t denormMagic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+  uint32_t bits = std::bit_cast<uint32_t>(value);
+  uint32_t sign = bits & 0x80000000u;
+  bits ^= sign;
+
+  uint32_t result = 0;
+  if (bits >= halfMax)
+  {
+    result = bits > infinity ? 0x7e00u : 0x7c00u;
+  }
+  else if (bits < (113u << 23))
+  {
+    // subnormal half, the float add aligns the mantissa and rounds
+    float aligned = std::bit_cast<float>(bits) + std::bit_cast<float>(denormMagic);
+    result = std::bit_cast<uint32_t>(aligned) - denormMagic;
+  }
+  else
+  {
+    uint32_t mantissaOdd = (bits >> 13) & 1u;
+    bits += ((15u - 127u) << 23) + 0xfffu;
+    bits += mantissaOdd;
+    result = bits >> 13;
+  }
+
+  return (uint16_t)(result | (sign >> 16));
+}
+
+/// @brief ieee 754 binary16 to float, exact
+constexpr float halfToFloat(uint16_t half)
+{
+  const uint32_t shiftedExp = 0x7c00u << 13;
+
+  uint32_t bits = (uint32_t)(half & 0x7fffu) << 13;
+  uint32_t exp = bits & shiftedExp;
+  bits += (127u - 15u) << 23;
+
+  if (exp == shiftedExp)
+  {
+    // infinity or nan
+    bits += (128u - 16u) << 23;
+  }
+  else if (exp == 0)
+  {
+    // zero or subnormal, renormalized through a float subtraction
+    bits += 1u << 23;
+    bits = std::bit_cast<uint32_t>(std::bit_cast<float>(bits) - std::bit_cast<float>(113u << 23));
+  }
+
+  return std::bit_cast<float>(bits | ((uint32_t)(half & 0x8000u) << 16));
+}
+
+/// @brief three half floats, 6 bytes instead of 12
+struct Vector3h
+{
+  uint16_t x;
+  uint16_t y;
+  uint16_t z;
+
+  constexpr Vector3h() : x(0), y(0), z(0) {}
+  constexpr explicit Vector3h(const Vector3f &v)
+      : x(floatToHalf(v.x)), y(floatToHalf(v.y)), z(floatToHalf(v.z)) {}
+
+  constexpr Vector3f unpack() const { return Vector3f(halfToFloat(x), halfToFloat(y), halfToFloat(z)); }
+};
+
+/// @brief four half floats, 8 bytes instead of 16
+struct Vector4h
+{
+  uint16_t x;
+  uint16_t y;
+  uint16_t z;
+  uint16_t w;
+
+  constexpr Vector4h() : x(0), y(0), z(0), w(0) {}
+  constexpr explicit Vector4h(const Vector4f &v)
+      : x(floatToHalf(v.x)), y(floatToHalf(v.y)), z(floatToHalf(v.z)), w(floatToHalf(v.w)) {}
+
+  constexpr Vector4f unpack() const
+  {
+    return Vector4f(halfToFloat(x), halfToFloat(y), halfToFloat(z), halfToFloat(w));
+  }
+};
+
+// smallest three quaternions
+//________________________________________________________________________
+//________________________________________________________________________
+
+// the largest component of a unit quaternion is implied by the other three,
+// which all lie in [-1/sqrt(2), 1/sqrt(2)]. q and -q are the same rotation so
+// the largest one can always be made positive and is not stored, only its
+// index (2 bits) and the three others, quantized uniformly. the largest code
+// is left unused so that 0 falls exactly on a code and identity round trips.
+
+#define QUAT48_MAX 0x7ffeu
+#define QUAT32_MAX 0x3feu
+
+namespace PackedHelpers
+{
+  constexpr float SQRT2 = 1.41421356f;
+
+  constexpr uint32_t quantize(float value, uint32_t maxValue)
+  {
+    float unit = clamp(value * (SQRT2 * 0.5f) + 0.5f, 0.0f, 1.0f);
+    return (uint32_t)(unit * maxValue + 0.5f);
+  }
+  constexpr float dequantize(uint32_t value, float invMaxValue)
+  {
+    return ((float)value * invMaxValue - 0.5f) * SQRT2;
+  }
+
+  /// @brief index of the largest absolute component and the other three in
+  /// order, sign adjusted so the dropped one is positive
+  constexpr int smallestThree(const Quat &q, float rest[3])
+  {
+    float c[4] = {q.x, q.y, q.z, q.s};
+
+    int largest = 0;
+    for (int i = 1; i < 4; i++)
+    {
+      if (cx_fabs(c[i]) > cx_fabs(c[largest]))
+      {
+        largest = i;
+      }
+    }
+
+    float sign = c[largest] < 0.0f ? -1.0f : 1.0f;
+    for (int i = 0, j = 0; i < 4; i++)
+    {
+      if (i != largest)
+      {
+        rest[j++] = c[i] * sign;
+      }
+    }
+    return largest;
+  }
+
+  constexpr Quat fromSmallestThree(int largest, float a, float b, float c)
+  {
+    float implied = cx_sqrt(max(0.0f, 1.0f - a * a - b * b - c * c));
+
+    switch (largest)
+    {
+    case 0:
+      return Quat(implied, a, b, c);
+    case 1:
+      return Quat(a, implied, b, c);
+    case 2:
+      return Quat(a, b, implied, c);
+    default:
+      return Quat(a, b, c, implied);
+    }
+  }
+}; // namespace PackedHelpers
+
+/// @brief unit quaternion in 48 bits, 15 bits per stored component. within
+/// 1.5e-4 rad of the input rotation
+struct Quat48
+{
+  // value << 1, the low bits of the first two words hold the index
+  uint16_t bits[3];
+
+  constexpr Quat48() : Quat48(Quat()) {}
+  constexpr explicit Quat48(const Quat &q) : bits{0, 0, 0}
+  {
+    float rest[3] = {};
+    int largest = PackedHelpers::smallestThree(q, rest);
+
+    for (int i = 0; i < 3; i++)
+    {
+      bits[i] = (uint16_t)(PackedHelpers::quantize(rest[i], QUAT48_MAX) << 1);
+    }
+    bits[0] |= largest & 1;
+    bits[1] |= (largest >> 1) & 1;
+  }
+
+  constexpr Quat unpack() const
+  {
+    const float inv = 1.0f / QUAT48_MAX;
+    int largest = (bits[0] & 1) | ((bits[1] & 1) << 1);
+    return PackedHelpers::fromSmallestThree(
+        largest,
+        PackedHelpers::dequantize(bits[0] >> 1, inv),
+        PackedHelpers::dequantize(bits[1] >> 1, inv),
+        PackedHelpers::dequantize(bits[2] >> 1, inv));
+  }
+};
+
+/// @brief unit quaternion in 32 bits, 2 bit index then 10 bits per stored
+/// component. within 4.5e-3 rad of the input rotation
+struct Quat32
+{
+  uint32_t bits;
+
+  constexpr Quat32() : Quat32(Quat()) {}
+  constexpr explicit Quat32(const Quat &q) : bits(0)
+  {
+    float rest[3] = {};
+    int largest = PackedHelpers::smallestThree(q, rest);
+
+    bits = (uint32_t)largest << 30 |
+           PackedHelpers::quantize(rest[0], QUAT32_MAX) << 20 |
+           PackedHelpers::quantize(rest[1], QUAT32_MAX) << 10 |
+           PackedHelpers::quantize(rest[2], QUAT32_MAX);
+  }
+
+  constexpr Quat unpack() const
+  {
+    const float inv = 1.0f / QUAT32_MAX;
+    return PackedHelpers::fromSmallestThree(
+        (int)(bits >> 30),
+        PackedHelpers::dequantize((bits >> 20) & 0x3ffu, inv),
+        PackedHelpers::dequantize((bits >> 10) & 0x3ffu, inv),
+        PackedHelpers::dequantize(bits & 0x3ffu, inv));
+  }
+};
+
+// octahedral unit vectors
+//________________________________________________________________________
+//________________________________________________________________________
+
+// the unit sphere is projected onto the octahedron |x|+|y|+|z| = 1, the lower
+// half folded over the upper one and the result flattened to a square that is
+// stored as two snorm values.
+
+namespace PackedHelpers
+{
+  constexpr float signNotZero(float value) { return value < 0.0f ? -1.0f : 1.0f; }
+
+  /// @brief unit vector to the [-1, 1] square
+  constexpr void octEncode(const Vector3f &v, float &u, float &w)
+  {
+    float invL1 = 1.0f / (cx_fabs(v.x) + cx_fabs(v.y) + cx_fabs(v.z));
+    u = v.x * invL1;
+    w = v.y * invL1;
+
+    if (v.z < 0.0f)
+    {
+      float fu = (1.0f - cx_fabs(w)) * signNotZero(u);
+      float fw = (1.0f - cx_fabs(u)) * signNotZero(w);
+      u = fu;
+      w = fw;
+    }
+  }
+
+  constexpr Vector3f octDecode(float u, float w)
+  {
+    Vector3f v = Vector3f(u, w, 1.0f - cx_fabs(u) - cx_fabs(w));
+    float fold = max(-v.z, 0.0f);
+    v.x += v.x >= 0.0f ? -fold : fold;
+    v.y += v.y >= 0.0f ? -fold : fold;
+    return v.unit();
+  }
+
+  constexpr int32_t toSnorm(float value, float scale)
+  {
+    float scaled = clamp(value, -1.0f, 1.0f) * scale;
+    return (int32_t)(scaled + (scaled < 0.0f ? -0.5f : 0.5f));
+  }
+}; // namespace PackedHelpers
+
+/// @brief unit vector in 16 bits, two 8 bit snorms. within 1.7e-2 rad of the
+/// input direction, enough for vertex normals of small or distant meshes
+struct Oct16
+{
+  int8_t u;
+  int8_t w;
+
+  constexpr Oct16() : u(0), w(0) {}
+  constexpr explicit Oct16(const Vector3f &v) : u(0), w(0)
+  {
+    float fu = 0.0f, fw = 0.0f;
+    PackedHelpers::octEncode(v, fu, fw);
+    u = (int8_t)PackedHelpers::toSnorm(fu, 127.0f);
+    w = (int8_t)PackedHelpers::toSnorm(fw, 127.0f);
+  }
+
+  constexpr Vector3f unpack() const { return PackedHelpers::octDecode(u / 127.0f, w / 127.0f); }
+};
+
+/// @brief unit vector in 32 bits, two 16 bit snorms. within 6.5e-5 rad of
+/// the input direction
+struct Oct32
+{
+  int16_t u;
+  int16_t w;
+
+  constexpr Oct32() : u(0), w(0) {}
+  constexpr explicit Oct32(const Vector3f &v) : u(0), w(0)
+  {
+    float fu = 0.0f, fw = 0.0f;
+    PackedHelpers::octEncode(v, fu, fw);
+    u = (int16_t)PackedHelpers::toSnorm(fu, 32767.0f);
+    w = (int16_t)PackedHelpers::toSnorm(fw, 32767.0f);
+  }
+
+  constexpr Vector3f unpack() const { return PackedHelpers::octDecode(u / 32767.0f, w / 32767.0f); }
+};
+
+#endif
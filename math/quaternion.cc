@@ -7,57 +7,6 @@
 
 #include "quaternion.h"
 #include "mat3.h"
-#include "mat4.h"
-#include "vec3.h"
-
-Quat::Quat(float angle, Vector3f axis)
-{
-  float s = std::sin(to_radians(angle / 2.0));
-  float c = std::cos(to_radians(angle / 2.0));
-
-  Vector3f unit = axis.unit();
-
-  this->s = c;
-  this->x = unit.x * s;
-  this->y = unit.y * s;
-  this->z = unit.z * s;
-}
-
-float Quat::norm() const
-{
-  float x2 = std::pow(x, 2.0);
-  float y2 = std::pow(y, 2.0);
-  float z2 = std::pow(z, 2.0);
-  float s2 = std::pow(s, 2.0);
-
-  return std::sqrt(x2 + y2 + z2 + s2);
-}
-
-Quat Quat::unit() const
-{
-  float coeff = 1.0 / this->norm();
-
-  return Quat(x * coeff, y * coeff, z * coeff, s * coeff);
-}
-
-Quat Quat::conjugate() const { return Quat(-x, -y, -z, s); }
-
-Quat Quat::inverse() const
-{
-  float lenSqrd = x * x + y * y + z * z + s * s;
-  float invLen = 1.0 / lenSqrd;
-
-  return this->conjugate() * invLen;
-}
-
-float dot(const Quat &lhs, const Quat &rhs)
-{
-  return lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z + lhs.s * rhs.s;
-}
-
-Vector3f axis(Quat q) { return Vector3f(q.x, q.y, q.z); }
-
-Quat mix(Quat from, Quat to, float t) { return (1.0 - t) * from + t * to; }
 
 Mat3x3 Quat::toMat3x3() const
 {
@@ -71,82 +20,72 @@ Mat3x3 Quat::toMat3x3() const
       _x.y, _y.y, _z.y,
       _x.z, _y.z, _z.z);
 }
-Mat4x4 Quat::toMat4x4() const
-{
-  Mat4x4 result = Mat4x4();
-
-  float x2 = std::pow(x, 2.0);
-  float y2 = std::pow(y, 2.0);
-  float z2 = std::pow(z, 2.0);
-  // first row
-  result.xx = 1.0 - 2.0 * (y2 + z2);
-  result.xy = 2.0 * (x * y - s * z);
-  result.xz = 2.0 * (x * z + s * y);
-  // second row
-  result.yx = 2.0 * (x * y + s * z);
-  result.yy = 1.0 - 2.0 * (x2 + z2);
-  result.yz = 2.0 * (y * z - s * x);
-  // third row
-  result.zx = 2.0 * (x * z - s * y);
-  result.zy = 2.0 * (y * z + s * x);
-  result.zz = 1.0 - 2.0 * (x2 + y2);
-
-  result.ww = 1.0;
-
-  return result;
-}
-// operator overloads
-//________________________________________________________________________
-//________________________________________________________________________
 
-Quat operator+(const Quat &lhs, const Quat &rhs)
+// the rest is constexpr in quaternion.h, checked at compile time here
+
+static_assert(Quat(1.0f, 2.0f, 3.0f, 4.0f) * Quat(1.0f, 2.0f, 3.0f, 4.0f).inverse() == Quat());
+static_assert(Quat(0.0f, 0.0f, 3.0f, 4.0f).unit() == Quat(0.0f, 0.0f, 0.6f, 0.8f));
+static_assert(Quat(90.0f, Vector3f(0.0f, 1.0f, 0.0f)) * Quat(-90.0f, Vector3f(0.0f, 1.0f, 0.0f)) == Quat());
+static_assert(mix(Quat(0.0f), Quat(1.0f), 0.25f) == Quat(0.25f));
+static_assert(cx_fabs((Quat(90.0f, Vector3f(0.0f, 0.0f, 1.0f)) * Vector3f(1.0f, 0.0f, 0.0f)).y - 1.0f) < VEC3_EPSILON);
+static_assert(Quat(90.0f, Vector3f(0.0f, 0.0f, 1.0f)).toMat4x4().yx ==
+              (Quat(90.0f, Vector3f(0.0f, 0.0f, 1.0f)) * Vector3f(1.0f, 0.0f, 0.0f)).y);
+
+// interpolation error against slerp evaluated in double precision, sweeping
+// the angle between the keys up to 180 degrees and t over [0, 1]. the angle
+// of conjugate(exact) * approx is taken from its vector part, acos of the
+// dot product alone is too coarse near 0 to measure the fast path. the
+// UtilsHelpers series stand in for <math.h>, which only gcc evaluates here
+namespace
 {
-  return Quat(
-      lhs.x + rhs.x,
-      lhs.y + rhs.y,
-      lhs.z + rhs.z,
-      lhs.s + rhs.s);
+  constexpr double angularError(Quat from, Quat to, float t, Quat approx)
+  {
+    double ca = (double)dot(from, to);
+    double sign = ca < 0.0 ? -1.0 : 1.0;
+    double angle = UtilsHelpers::acosSeries(ca * sign);
+    double sinAngle = UtilsHelpers::sinSeries(angle);
+    double w0 = angle < 1e-9 ? 1.0 - t : UtilsHelpers::sinSeries((1.0 - t) * angle) / sinAngle;
+    double w1 = angle < 1e-9 ? t : sign * UtilsHelpers::sinSeries(t * angle) / sinAngle;
+
+    double ex = w0 * from.x + w1 * to.x, ey = w0 * from.y + w1 * to.y;
+    double ez = w0 * from.z + w1 * to.z, es = w0 * from.s + w1 * to.s;
+
+    double x = es * approx.x - ex * approx.s - ey * approx.z + ez * approx.y;
+    double y = es * approx.y - ey * approx.s - ez * approx.x + ex * approx.z;
+    double z = es * approx.z - ez * approx.s - ex * approx.y + ey * approx.x;
+    double s = es * approx.s + ex * approx.x + ey * approx.y + ez * approx.z;
+
+    // atan2(|v|, |s|) as asin(|v| / |q|), switching to acos near 1
+    double v = UtilsHelpers::sqrtSeries(x * x + y * y + z * z);
+    double sine = v / UtilsHelpers::sqrtSeries(v * v + s * s);
+    sine = sine < 1.0 ? sine : 1.0;
+    if (sine <= 0.5)
+    {
+      return 2.0 * UtilsHelpers::asinSeries(sine);
+    }
+    return 2.0 * (UtilsHelpers::PI / 2.0 - UtilsHelpers::acosSeries(sine));
+  }
+
+  constexpr double maxAngularError(QuatInterp mode)
+  {
+    double worst = 0.0;
+    Quat from = Quat(37.0f, Vector3f(1.0f, 2.0f, 3.0f));
+    for (int a = 0; a <= 60; a++)
+    {
+      Quat to = (from * Quat(3.0f * a, Vector3f(-1.0f, 0.3f, 2.0f))).unit();
+      // odd steps land in the other hemisphere to cover the flip
+      to = a % 2 ? -1.0f * to : to;
+      for (int i = 0; i <= 32; i++)
+      {
+        float t = i / 32.0f;
+        double error = angularError(from, to, t, interpolate(from, to, t, mode));
+        worst = error > worst ? error : worst;
+      }
+    }
+    return worst;
+  }
 }
 
-Quat operator*(float lhs, const Quat &rhs)
-{
-  return Quat(
-      lhs * rhs.x,
-      lhs * rhs.y,
-      lhs * rhs.z,
-      lhs * rhs.s);
-}
-Quat operator*(const Quat lhs, float &rhs) { return rhs * lhs; }
-
-Vector3f operator*(const Quat &lhs, const Vector3f &rhs)
-{
-  Vector3f a = axis(lhs) * 2.0 * dot(axis(lhs), rhs);
-  Vector3f b = rhs * (lhs.s * lhs.s - dot(axis(lhs), axis(lhs)));
-  Vector3f c = cross(axis(lhs), rhs) * 2.0 * lhs.s;
-
-  return a + b + c;
-}
-
-Vector3f operator*(Vector3f &lhs, Quat &rhs) { return rhs * lhs; }
-
-Quat operator*(const Quat &lhs, const Quat &rhs)
-{
-  Quat result = Quat(0.0);
-
-  result.x = lhs.s * rhs.x + lhs.x * rhs.s + lhs.y * rhs.z - lhs.z * rhs.y;
-  result.y = lhs.s * rhs.y + lhs.y * rhs.s + lhs.z * rhs.x - lhs.x * rhs.z;
-  result.z = lhs.s * rhs.z + lhs.z * rhs.s + lhs.x * rhs.y - lhs.y * rhs.x;
-  result.s = lhs.s * rhs.s - lhs.x * rhs.x - lhs.y * rhs.y - lhs.z * rhs.z;
-
-  return result;
-}
-
-bool operator==(const Quat &left, const Quat &right)
-{
-  return (
-      fabsf(left.x - right.x) <= QUAT_EPSILON &&
-      fabsf(left.y - right.y) <= QUAT_EPSILON &&
-      fabsf(left.z - right.z) <= QUAT_EPSILON &&
-      fabsf(left.s - right.s) <= QUAT_EPSILON);
-}
-bool operator!=(const Quat &a, const Quat &b) { return !(a == b); }
+static_assert(maxAngularError(QuatSlerp) < 1e-5);
+static_assert(maxAngularError(QuatFastNlerp) < 1e-3);
+static_assert(maxAngularError(QuatNlerp) < 0.15);
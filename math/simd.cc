@@ -0,0 +1,343 @@
+#include "simd.h"
+#include "vec3.h"
+
+#ifdef MATH_SIMD_X86
+#include <immintrin.h>
+#endif
+
+// scalar reference kernels, the single value ones are constexpr in mat4.h
+//________________________________________________________________________
+//________________________________________________________________________
+
+void mat4MulBatchScalar(const Mat4x4 *l, const Mat4x4 *r, Mat4x4 *out, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    out[i] = mat4MulScalar(l[i], r[i]);
+  }
+}
+
+static const Mat4Kernels scalarKernels = {
+    .mul = mat4MulScalar,
+    .mulVec = mat4MulVecScalar,
+    .transpose = mat4TransposeScalar,
+    .inverseAffine = mat4InverseAffineScalar,
+    .mulBatch = mat4MulBatchScalar,
+};
+
+#ifdef MATH_SIMD_X86
+
+// sse4.1 kernels
+//________________________________________________________________________
+//________________________________________________________________________
+
+#define SSE4 __attribute__((target("sse4.1")))
+#define AVX2 __attribute__((target("avx2,fma")))
+
+SSE4 static inline __m128 cross3(__m128 a, __m128 b)
+{
+  __m128 aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+  __m128 bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+  __m128 c = _mm_sub_ps(_mm_mul_ps(a, bYZX), _mm_mul_ps(aYZX, b));
+  return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+SSE4 static inline __m128 splat(__m128 v, int i)
+{
+  switch (i)
+  {
+  case 0:
+    return _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0));
+  case 1:
+    return _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1));
+  case 2:
+    return _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2));
+  default:
+    return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+  }
+}
+
+// one row of l times r, with r's rows already in registers
+#define SSE4_ROW(a)                                                                  \
+  _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(a, a, 0x00), r0),                 \
+                        _mm_mul_ps(_mm_shuffle_ps(a, a, 0x55), r1)),                \
+             _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(a, a, 0xAA), r2),                 \
+                        _mm_mul_ps(_mm_shuffle_ps(a, a, 0xFF), r3)))
+
+SSE4 static Mat4x4 mat4MulSSE4(const Mat4x4 &l, const Mat4x4 &r)
+{
+  __m128 r0 = _mm_loadu_ps(r.rc[0]);
+  __m128 r1 = _mm_loadu_ps(r.rc[1]);
+  __m128 r2 = _mm_loadu_ps(r.rc[2]);
+  __m128 r3 = _mm_loadu_ps(r.rc[3]);
+
+  Mat4x4 result;
+  for (int i = 0; i < 4; i++)
+  {
+    __m128 a = _mm_loadu_ps(l.rc[i]);
+    _mm_storeu_ps(result.rc[i], SSE4_ROW(a));
+  }
+  return result;
+}
+
+SSE4 static Vector4f mat4MulVecSSE4(const Mat4x4 &m, const Vector4f &v)
+{
+  __m128 vec = _mm_loadu_ps(v.v);
+  __m128 p0 = _mm_mul_ps(_mm_loadu_ps(m.rc[0]), vec);
+  __m128 p1 = _mm_mul_ps(_mm_loadu_ps(m.rc[1]), vec);
+  __m128 p2 = _mm_mul_ps(_mm_loadu_ps(m.rc[2]), vec);
+  __m128 p3 = _mm_mul_ps(_mm_loadu_ps(m.rc[3]), vec);
+
+  Vector4f result;
+  _mm_storeu_ps(result.v, _mm_hadd_ps(_mm_hadd_ps(p0, p1), _mm_hadd_ps(p2, p3)));
+  return result;
+}
+
+SSE4 static Mat4x4 mat4TransposeSSE4(const Mat4x4 &m)
+{
+  __m128 r0 = _mm_loadu_ps(m.rc[0]);
+  __m128 r1 = _mm_loadu_ps(m.rc[1]);
+  __m128 r2 = _mm_loadu_ps(m.rc[2]);
+  __m128 r3 = _mm_loadu_ps(m.rc[3]);
+  _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+  Mat4x4 result;
+  _mm_storeu_ps(result.rc[0], r0);
+  _mm_storeu_ps(result.rc[1], r1);
+  _mm_storeu_ps(result.rc[2], r2);
+  _mm_storeu_ps(result.rc[3], r3);
+  return result;
+}
+
+SSE4 static Mat4x4 mat4InverseAffineSSE4(const Mat4x4 &m)
+{
+  __m128 r0 = _mm_loadu_ps(m.rc[0]);
+  __m128 r1 = _mm_loadu_ps(m.rc[1]);
+  __m128 r2 = _mm_loadu_ps(m.rc[2]);
+
+  // w lanes of the crosses cancel out, so the translation column is ignored
+  __m128 c0 = cross3(r1, r2);
+  __m128 c1 = cross3(r2, r0);
+  __m128 c2 = cross3(r0, r1);
+
+  __m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), _mm_dp_ps(r0, c0, 0x7F));
+  c0 = _mm_mul_ps(c0, invDet);
+  c1 = _mm_mul_ps(c1, invDet);
+  c2 = _mm_mul_ps(c2, invDet);
+
+  __m128 t = _mm_mul_ps(c0, splat(r0, 3));
+  t = _mm_add_ps(t, _mm_mul_ps(c1, splat(r1, 3)));
+  t = _mm_add_ps(t, _mm_mul_ps(c2, splat(r2, 3)));
+  __m128 c3 = _mm_blend_ps(_mm_sub_ps(_mm_setzero_ps(), t), _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f), 0x8);
+
+  _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+  Mat4x4 result;
+  _mm_storeu_ps(result.rc[0], c0);
+  _mm_storeu_ps(result.rc[1], c1);
+  _mm_storeu_ps(result.rc[2], c2);
+  _mm_storeu_ps(result.rc[3], c3);
+  return result;
+}
+
+SSE4 static void mat4MulBatchSSE4(const Mat4x4 *l, const Mat4x4 *r, Mat4x4 *out, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    // every input row is loaded before the first store, out may alias l or
+    // r. stored straight into out instead of through a returned Mat4x4
+    __m128 r0 = _mm_loadu_ps(r[i].rc[0]);
+    __m128 r1 = _mm_loadu_ps(r[i].rc[1]);
+    __m128 r2 = _mm_loadu_ps(r[i].rc[2]);
+    __m128 r3 = _mm_loadu_ps(r[i].rc[3]);
+    __m128 a0 = _mm_loadu_ps(l[i].rc[0]);
+    __m128 a1 = _mm_loadu_ps(l[i].rc[1]);
+    __m128 a2 = _mm_loadu_ps(l[i].rc[2]);
+    __m128 a3 = _mm_loadu_ps(l[i].rc[3]);
+
+    _mm_storeu_ps(out[i].rc[0], SSE4_ROW(a0));
+    _mm_storeu_ps(out[i].rc[1], SSE4_ROW(a1));
+    _mm_storeu_ps(out[i].rc[2], SSE4_ROW(a2));
+    _mm_storeu_ps(out[i].rc[3], SSE4_ROW(a3));
+  }
+}
+
+static const Mat4Kernels sse4Kernels = {
+    .mul = mat4MulSSE4,
+    .mulVec = mat4MulVecSSE4,
+    .transpose = mat4TransposeSSE4,
+    .inverseAffine = mat4InverseAffineSSE4,
+    .mulBatch = mat4MulBatchSSE4,
+};
+
+// avx2 + fma kernels, two matrix rows per register
+//________________________________________________________________________
+//________________________________________________________________________
+
+AVX2 static Mat4x4 mat4MulAVX2(const Mat4x4 &l, const Mat4x4 &r)
+{
+  __m256 r0 = _mm256_broadcast_ps((const __m128 *)r.rc[0]);
+  __m256 r1 = _mm256_broadcast_ps((const __m128 *)r.rc[1]);
+  __m256 r2 = _mm256_broadcast_ps((const __m128 *)r.rc[2]);
+  __m256 r3 = _mm256_broadcast_ps((const __m128 *)r.rc[3]);
+
+  Mat4x4 result;
+  for (int i = 0; i < 4; i += 2)
+  {
+    __m256 a = _mm256_loadu_ps(l.rc[i]);
+    __m256 rows = _mm256_mul_ps(_mm256_shuffle_ps(a, a, 0x00), r0);
+    rows = _mm256_fmadd_ps(_mm256_shuffle_ps(a, a, 0x55), r1, rows);
+    rows = _mm256_fmadd_ps(_mm256_shuffle_ps(a, a, 0xAA), r2, rows);
+    rows = _mm256_fmadd_ps(_mm256_shuffle_ps(a, a, 0xFF), r3, rows);
+    _mm256_storeu_ps(result.rc[i], rows);
+  }
+  return result;
+}
+
+AVX2 static Vector4f mat4MulVecAVX2(const Mat4x4 &m, const Vector4f &v)
+{
+  __m256 vec = _mm256_broadcast_ps((const __m128 *)v.v);
+  __m256 p01 = _mm256_mul_ps(_mm256_loadu_ps(m.rc[0]), vec);
+  __m256 p23 = _mm256_mul_ps(_mm256_loadu_ps(m.rc[2]), vec);
+
+  // lane 0 ends up as (r0, r2, r0, r2) and lane 1 as (r1, r3, r1, r3)
+  __m256 sums = _mm256_hadd_ps(p01, p23);
+  sums = _mm256_hadd_ps(sums, sums);
+
+  __m128 lo = _mm256_castps256_ps128(sums);
+  __m128 hi = _mm256_extractf128_ps(sums, 1);
+
+  Vector4f result;
+  _mm_storeu_ps(result.v, _mm_unpacklo_ps(lo, hi));
+  return result;
+}
+
+AVX2 static Mat4x4 mat4TransposeAVX2(const Mat4x4 &m)
+{
+  const __m256i interleave = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  // (r0[0], r1[0], r0[1], r1[1], ...) and the same for rows 2 and 3
+  __m256 p01 = _mm256_permutevar8x32_ps(_mm256_loadu_ps(m.rc[0]), interleave);
+  __m256 p23 = _mm256_permutevar8x32_ps(_mm256_loadu_ps(m.rc[2]), interleave);
+
+  __m256d c02 = _mm256_unpacklo_pd(_mm256_castps_pd(p01), _mm256_castps_pd(p23));
+  __m256d c13 = _mm256_unpackhi_pd(_mm256_castps_pd(p01), _mm256_castps_pd(p23));
+
+  Mat4x4 result;
+  _mm256_storeu_ps(result.rc[0], _mm256_castpd_ps(_mm256_permute2f128_pd(c02, c13, 0x20)));
+  _mm256_storeu_ps(result.rc[2], _mm256_castpd_ps(_mm256_permute2f128_pd(c02, c13, 0x31)));
+  return result;
+}
+
+AVX2 static Mat4x4 mat4InverseAffineAVX2(const Mat4x4 &m)
+{
+  __m128 r0 = _mm_loadu_ps(m.rc[0]);
+  __m128 r1 = _mm_loadu_ps(m.rc[1]);
+  __m128 r2 = _mm_loadu_ps(m.rc[2]);
+
+  __m128 c0 = cross3(r1, r2);
+  __m128 c1 = cross3(r2, r0);
+  __m128 c2 = cross3(r0, r1);
+
+  __m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), _mm_dp_ps(r0, c0, 0x7F));
+  c0 = _mm_mul_ps(c0, invDet);
+  c1 = _mm_mul_ps(c1, invDet);
+  c2 = _mm_mul_ps(c2, invDet);
+
+  __m128 t = _mm_mul_ps(c0, _mm_permute_ps(r0, 0xFF));
+  t = _mm_fmadd_ps(c1, _mm_permute_ps(r1, 0xFF), t);
+  t = _mm_fmadd_ps(c2, _mm_permute_ps(r2, 0xFF), t);
+  __m128 c3 = _mm_blend_ps(_mm_sub_ps(_mm_setzero_ps(), t), _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f), 0x8);
+
+  _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+  Mat4x4 result;
+  _mm_storeu_ps(result.rc[0], c0);
+  _mm_storeu_ps(result.rc[1], c1);
+  _mm_storeu_ps(result.rc[2], c2);
+  _mm_storeu_ps(result.rc[3], c3);
+  return result;
+}
+
+AVX2 static void mat4MulBatchAVX2(const Mat4x4 *l, const Mat4x4 *r, Mat4x4 *out, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    out[i] = mat4MulAVX2(l[i], r[i]);
+  }
+}
+
+static const Mat4Kernels avx2Kernels = {
+    .mul = mat4MulAVX2,
+    .mulVec = mat4MulVecAVX2,
+    .transpose = mat4TransposeAVX2,
+    .inverseAffine = mat4InverseAffineAVX2,
+    .mulBatch = mat4MulBatchAVX2,
+};
+
+#endif
+
+// dispatch
+//________________________________________________________________________
+//________________________________________________________________________
+
+static SimdLevel detectSimdLevel()
+{
+#ifdef MATH_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+  {
+    return SimdAVX2;
+  }
+  if (__builtin_cpu_supports("sse4.1"))
+  {
+    return SimdSSE4;
+  }
+#endif
+  return SimdScalar;
+}
+
+SimdLevel simdLevel()
+{
+  static const SimdLevel level = detectSimdLevel();
+  return level;
+}
+
+const char *simdLevelName(SimdLevel level)
+{
+  switch (level)
+  {
+  case SimdAVX2:
+    return "avx2";
+  case SimdSSE4:
+    return "sse4";
+  default:
+    return "scalar";
+  }
+}
+
+const Mat4Kernels &mat4Kernels(SimdLevel level)
+{
+  if (level > simdLevel())
+  {
+    level = simdLevel();
+  }
+
+#ifdef MATH_SIMD_X86
+  switch (level)
+  {
+  case SimdAVX2:
+    return avx2Kernels;
+  case SimdSSE4:
+    return sse4Kernels;
+  default:
+    break;
+  }
+#endif
+  return scalarKernels;
+}
+
+const Mat4Kernels &mat4Kernels()
+{
+  static const Mat4Kernels &kernels = mat4Kernels(simdLevel());
+  return kernels;
+}
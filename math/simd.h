@@ -0,0 +1,48 @@
+#ifndef MATH_SIMD_H
+#define MATH_SIMD_H
+
+#include "mat4.h"
+#include "vec4.h"
+
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define MATH_SIMD_X86
+#endif
+
+/// @brief instruction sets the math kernels can run on
+enum SimdLevel
+{
+  SimdScalar,
+  SimdSSE4,
+  SimdAVX2,
+};
+
+/// @brief one implementation of the hot Mat4x4 operations, for the batch
+/// apis. the per value operators in mat4.h stay inline scalar code, an
+/// indirect call per matrix costs more than the simd saves
+struct Mat4Kernels
+{
+  Mat4x4 (*mul)(const Mat4x4 &l, const Mat4x4 &r);
+  Vector4f (*mulVec)(const Mat4x4 &m, const Vector4f &v);
+  Mat4x4 (*transpose)(const Mat4x4 &m);
+  Mat4x4 (*inverseAffine)(const Mat4x4 &m);
+  /// @brief out[i] = l[i] * r[i] for n matrices, out may alias l or r
+  void (*mulBatch)(const Mat4x4 *l, const Mat4x4 *r, Mat4x4 *out, size_t n);
+};
+
+/// @brief best instruction set the running cpu supports, queried through
+/// cpuid the first time it is asked for
+SimdLevel simdLevel();
+const char *simdLevelName(SimdLevel level);
+
+/// @brief kernels for a given instruction set, falls back to the scalar ones
+/// when the cpu (or the compiler target) does not support it
+const Mat4Kernels &mat4Kernels(SimdLevel level);
+/// @brief kernels picked for this cpu, selected once and reused afterwards
+const Mat4Kernels &mat4Kernels();
+
+// scalar reference batch, the single value references live in mat4.h
+void mat4MulBatchScalar(const Mat4x4 *l, const Mat4x4 *r, Mat4x4 *out, size_t n);
+
+#endif
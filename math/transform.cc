@@ -1,55 +1,5 @@
 #include "transform.h"
 
-Mat4x4 Transform::get() const
-{
-  Vector3f x = orientation * Vector3f(1.0, 0.0, 0.0);
-  Vector3f y = orientation * Vector3f(0.0, 1.0, 0.0);
-  Vector3f z = orientation * Vector3f(0.0, 0.0, 1.0);
-
-  x = x * scaling.x;
-  y = y * scaling.y;
-  z = z * scaling.z;
-
-  Vector3f p = translation;
-
-  return Mat4x4(
-      x.x, y.x, z.x, p.x, //
-      x.y, y.y, z.y, p.y, //
-      x.z, y.z, z.z, p.z, //
-      0.0, 0.0, 0.0, 1.0  //
-  );
-}
-
-Transform Transform::inverse() const
-{
-  Transform inv = Transform();
-
-  inv.orientation = orientation.inverse();
-
-  inv.scaling.x = 1.0 / scaling.x;
-  inv.scaling.y = 1.0 / scaling.y;
-  inv.scaling.z = 1.0 / scaling.z;
-
-  Vector3f inv_trans = -1.0 * translation;
-  inv.translation = inv.orientation * (inv.scaling * inv_trans);
-
-  return inv;
-}
-
-Transform combine(const Transform &t1, const Transform &t2)
-{
-  Transform result = Transform();
-
-  result.scaling = t1.scaling * t2.scaling;
-
-  result.orientation = t1.orientation * t2.orientation;
-  // mhhhh have no idea what this is
-  result.translation = t1.orientation * (t1.scaling * t2.translation);
-
-  result.translation = t1.translation + result.translation;
-
-  return result;
-}
 Transform transformFromMat(const Mat4x4 &mat)
 {
   Transform transform = Transform();
@@ -75,3 +25,11 @@ Transform transformFromMat(const Mat4x4 &mat)
 
   return transform;
 }
+
+Transform transformFromMat(const Mat3x4 &mat) { return transformFromMat(mat.toMat4x4()); }
+
+// get, getAffine, inverse and combine are constexpr in transform.h
+
+static_assert(Transform().get() == identity());
+static_assert(combine(Transform(), Transform()).get() == identity());
+static_assert(Transform().getAffine().toMat4x4() == Transform().get());
@@ -1,6 +1,7 @@
 #ifndef TRANSFORM_H
 #define TRANSFORM_H
 
+#include "mat3x4.h"
 #include "mat4.h"
 #include "quaternion.h"
 #include "vec3.h"
@@ -8,11 +9,11 @@
 class Transform
 {
 public:
-  Transform()
+  constexpr Transform()
       : translation(Vector3f()),
         orientation(Quat()),
         scaling(Vector3f(1.0)) {};
-  ~Transform() {};
+  constexpr ~Transform() {};
 
   Vector3f translation;
   Quat orientation;
@@ -21,11 +22,84 @@ public:
   /// @brief combines the translation, rotation and scaling members to produce a
   /// transformation matrix
   /// @return finall transform matrix
-  Mat4x4 get() const;
-  Transform inverse() const;
+  constexpr Mat4x4 get() const;
+  /// @brief same as get() without the constant last row
+  /// @return affine transform matrix
+  constexpr Mat3x4 getAffine() const;
+  constexpr Transform inverse() const;
 };
 
-Transform combine(const Transform &t1, const Transform &t2);
+constexpr Mat4x4 Transform::get() const
+{
+  Vector3f x = orientation * Vector3f(1.0, 0.0, 0.0);
+  Vector3f y = orientation * Vector3f(0.0, 1.0, 0.0);
+  Vector3f z = orientation * Vector3f(0.0, 0.0, 1.0);
+
+  x = x * scaling.x;
+  y = y * scaling.y;
+  z = z * scaling.z;
+
+  Vector3f p = translation;
+
+  return Mat4x4(
+      x.x, y.x, z.x, p.x, //
+      x.y, y.y, z.y, p.y, //
+      x.z, y.z, z.z, p.z, //
+      0.0, 0.0, 0.0, 1.0  //
+  );
+}
+
+constexpr Mat3x4 Transform::getAffine() const
+{
+  Vector3f x = orientation * Vector3f(1.0, 0.0, 0.0);
+  Vector3f y = orientation * Vector3f(0.0, 1.0, 0.0);
+  Vector3f z = orientation * Vector3f(0.0, 0.0, 1.0);
+
+  x = x * scaling.x;
+  y = y * scaling.y;
+  z = z * scaling.z;
+
+  Vector3f p = translation;
+
+  return Mat3x4(
+      x.x, y.x, z.x, p.x, //
+      x.y, y.y, z.y, p.y, //
+      x.z, y.z, z.z, p.z  //
+  );
+}
+
+constexpr Transform Transform::inverse() const
+{
+  Transform inv = Transform();
+
+  inv.orientation = orientation.inverse();
+
+  inv.scaling.x = 1.0f / scaling.x;
+  inv.scaling.y = 1.0f / scaling.y;
+  inv.scaling.z = 1.0f / scaling.z;
+
+  Vector3f inv_trans = -1.0f * translation;
+  inv.translation = inv.orientation * (inv.scaling * inv_trans);
+
+  return inv;
+}
+
+constexpr Transform combine(const Transform &t1, const Transform &t2)
+{
+  Transform result = Transform();
+
+  result.scaling = t1.scaling * t2.scaling;
+
+  result.orientation = t1.orientation * t2.orientation;
+  // mhhhh have no idea what this is
+  result.translation = t1.orientation * (t1.scaling * t2.translation);
+
+  result.translation = t1.translation + result.translation;
+
+  return result;
+}
+
 Transform transformFromMat(const Mat4x4 &mat);
+Transform transformFromMat(const Mat3x4 &mat);
 
 #endif
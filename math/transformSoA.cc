@@ -0,0 +1,467 @@
+#include "transformSoA.h"
+#include "simd.h"
+
+#include <algorithm>
+
+// the kernels are written once against gcc vector types and instantiated
+// twice: 4 lanes (plain sse, always available) and 8 lanes inside functions
+// compiled for avx2, picked at runtime through simdLevel().
+
+typedef float float4v __attribute__((vector_size(16)));
+typedef int int4v __attribute__((vector_size(16)));
+typedef float float8v __attribute__((vector_size(32)));
+typedef int int8v __attribute__((vector_size(32)));
+
+static const float identityValues[SoAStreamCount] = {
+    0.0f, 0.0f, 0.0f,       // position
+    0.0f, 0.0f, 0.0f, 1.0f, // rotation
+    1.0f, 1.0f, 1.0f,       // scale
+};
+
+TransformSoA::TransformSoA(size_t n) : count(0), groups(0) { this->resize(n); }
+
+void TransformSoA::resize(size_t n)
+{
+  size_t newGroups = (n + SOA_LANES - 1) / SOA_LANES;
+
+  if (newGroups != this->groups)
+  {
+    std::vector<Lanes> newData(SoAStreamCount * newGroups);
+    size_t keep = std::min(this->groups, newGroups);
+    for (int s = 0; s < SoAStreamCount; s++)
+    {
+      std::copy_n(this->data.data() + s * this->groups, keep, newData.data() + s * newGroups);
+    }
+    this->data.swap(newData);
+    this->groups = newGroups;
+  }
+
+  // everything past the old size is reset, that includes the padding lanes
+  size_t padded = this->paddedSize();
+  for (int s = 0; s < SoAStreamCount; s++)
+  {
+    float *values = this->stream((SoAStream)s);
+    std::fill(values + std::min(this->count, n), values + padded, identityValues[s]);
+  }
+  this->count = n;
+}
+
+size_t TransformSoA::size() const { return this->count; }
+size_t TransformSoA::paddedSize() const { return this->groups * SOA_LANES; }
+
+float *TransformSoA::stream(SoAStream s)
+{
+  return reinterpret_cast<float *>(this->data.data() + s * this->groups);
+}
+const float *TransformSoA::stream(SoAStream s) const
+{
+  return reinterpret_cast<const float *>(this->data.data() + s * this->groups);
+}
+
+Transform TransformSoA::getTransform(size_t index) const
+{
+  Transform result;
+  result.translation = Vector3f(
+      this->stream(SoAPosX)[index],
+      this->stream(SoAPosY)[index],
+      this->stream(SoAPosZ)[index]);
+  result.orientation = Quat(
+      this->stream(SoARotX)[index],
+      this->stream(SoARotY)[index],
+      this->stream(SoARotZ)[index],
+      this->stream(SoARotW)[index]);
+  result.scaling = Vector3f(
+      this->stream(SoAScaleX)[index],
+      this->stream(SoAScaleY)[index],
+      this->stream(SoAScaleZ)[index]);
+  return result;
+}
+
+void TransformSoA::setTransform(size_t index, const Transform &transform)
+{
+  this->stream(SoAPosX)[index] = transform.translation.x;
+  this->stream(SoAPosY)[index] = transform.translation.y;
+  this->stream(SoAPosZ)[index] = transform.translation.z;
+  this->stream(SoARotX)[index] = transform.orientation.x;
+  this->stream(SoARotY)[index] = transform.orientation.y;
+  this->stream(SoARotZ)[index] = transform.orientation.z;
+  this->stream(SoARotW)[index] = transform.orientation.s;
+  this->stream(SoAScaleX)[index] = transform.scaling.x;
+  this->stream(SoAScaleY)[index] = transform.scaling.y;
+  this->stream(SoAScaleZ)[index] = transform.scaling.z;
+}
+
+void TransformSoA::load(std::span<const Transform> transforms)
+{
+  this->resize(transforms.size());
+  for (size_t i = 0; i < transforms.size(); i++)
+  {
+    this->setTransform(i, transforms[i]);
+  }
+}
+
+void TransformSoA::store(std::span<Transform> out) const
+{
+  size_t n = std::min(out.size(), this->count);
+  for (size_t i = 0; i < n; i++)
+  {
+    out[i] = this->getTransform(i);
+  }
+}
+
+// kernels
+//________________________________________________________________________
+//________________________________________________________________________
+
+template <typename V>
+[[gnu::always_inline]] static inline void combineLanes(const TransformSoA &parents, const TransformSoA &children, TransformSoA &out)
+{
+  const float *ptx = parents.stream(SoAPosX), *pty = parents.stream(SoAPosY), *ptz = parents.stream(SoAPosZ);
+  const float *prx = parents.stream(SoARotX), *pry = parents.stream(SoARotY), *prz = parents.stream(SoARotZ), *prw = parents.stream(SoARotW);
+  const float *psx = parents.stream(SoAScaleX), *psy = parents.stream(SoAScaleY), *psz = parents.stream(SoAScaleZ);
+
+  const float *ctx = children.stream(SoAPosX), *cty = children.stream(SoAPosY), *ctz = children.stream(SoAPosZ);
+  const float *crx = children.stream(SoARotX), *cry = children.stream(SoARotY), *crz = children.stream(SoARotZ), *crw = children.stream(SoARotW);
+  const float *csx = children.stream(SoAScaleX), *csy = children.stream(SoAScaleY), *csz = children.stream(SoAScaleZ);
+
+  float *otx = out.stream(SoAPosX), *oty = out.stream(SoAPosY), *otz = out.stream(SoAPosZ);
+  float *orx = out.stream(SoARotX), *ory = out.stream(SoARotY), *orz = out.stream(SoARotZ), *orw = out.stream(SoARotW);
+  float *osx = out.stream(SoAScaleX), *osy = out.stream(SoAScaleY), *osz = out.stream(SoAScaleZ);
+
+  const size_t width = sizeof(V) / sizeof(float);
+  const size_t padded = out.paddedSize();
+  for (size_t i = 0; i < padded; i += width)
+  {
+    V px = *(const V *)(prx + i), py = *(const V *)(pry + i), pz = *(const V *)(prz + i), pw = *(const V *)(prw + i);
+    V cx = *(const V *)(crx + i), cy = *(const V *)(cry + i), cz = *(const V *)(crz + i), cw = *(const V *)(crw + i);
+    V sx = *(const V *)(psx + i), sy = *(const V *)(psy + i), sz = *(const V *)(psz + i);
+
+    // child translation scaled, then rotated by the parent orientation
+    V vx = sx * *(const V *)(ctx + i);
+    V vy = sy * *(const V *)(cty + i);
+    V vz = sz * *(const V *)(ctz + i);
+
+    V d = 2.0f * (px * vx + py * vy + pz * vz);
+    V k = pw * pw - (px * px + py * py + pz * pz);
+    V w2 = 2.0f * pw;
+
+    *(V *)(otx + i) = *(const V *)(ptx + i) + px * d + vx * k + (py * vz - pz * vy) * w2;
+    *(V *)(oty + i) = *(const V *)(pty + i) + py * d + vy * k + (pz * vx - px * vz) * w2;
+    *(V *)(otz + i) = *(const V *)(ptz + i) + pz * d + vz * k + (px * vy - py * vx) * w2;
+
+    *(V *)(osx + i) = sx * *(const V *)(csx + i);
+    *(V *)(osy + i) = sy * *(const V *)(csy + i);
+    *(V *)(osz + i) = sz * *(const V *)(csz + i);
+
+    *(V *)(orx + i) = pw * cx + px * cw + py * cz - pz * cy;
+    *(V *)(ory + i) = pw * cy + py * cw + pz * cx - px * cz;
+    *(V *)(orz + i) = pw * cz + pz * cw + px * cy - py * cx;
+    *(V *)(orw + i) = pw * cw - px * cx - py * cy - pz * cz;
+  }
+}
+
+template <typename V>
+[[gnu::always_inline]] static inline void getLanes(const TransformSoA &transforms, std::span<Mat4x4> out)
+{
+  const size_t width = sizeof(V) / sizeof(float);
+  const size_t n = std::min(out.size(), transforms.size());
+
+  // one column per matrix element of the upper 3x4 block
+  alignas(32) float cols[12][width];
+
+  for (size_t i = 0; i < n; i += width)
+  {
+    V x = *(const V *)(transforms.stream(SoARotX) + i);
+    V y = *(const V *)(transforms.stream(SoARotY) + i);
+    V z = *(const V *)(transforms.stream(SoARotZ) + i);
+    V w = *(const V *)(transforms.stream(SoARotW) + i);
+    V sx = *(const V *)(transforms.stream(SoAScaleX) + i);
+    V sy = *(const V *)(transforms.stream(SoAScaleY) + i);
+    V sz = *(const V *)(transforms.stream(SoAScaleZ) + i);
+
+    V xx = x * x, yy = y * y, zz = z * z, ww = w * w;
+    V xy2 = 2.0f * x * y, xz2 = 2.0f * x * z, yz2 = 2.0f * y * z;
+    V wx2 = 2.0f * w * x, wy2 = 2.0f * w * y, wz2 = 2.0f * w * z;
+
+    *(V *)cols[0] = (ww + xx - yy - zz) * sx;
+    *(V *)cols[1] = (xy2 - wz2) * sy;
+    *(V *)cols[2] = (xz2 + wy2) * sz;
+    *(V *)cols[3] = *(const V *)(transforms.stream(SoAPosX) + i);
+
+    *(V *)cols[4] = (xy2 + wz2) * sx;
+    *(V *)cols[5] = (ww - xx + yy - zz) * sy;
+    *(V *)cols[6] = (yz2 - wx2) * sz;
+    *(V *)cols[7] = *(const V *)(transforms.stream(SoAPosY) + i);
+
+    *(V *)cols[8] = (xz2 - wy2) * sx;
+    *(V *)cols[9] = (yz2 + wx2) * sy;
+    *(V *)cols[10] = (ww - xx - yy + zz) * sz;
+    *(V *)cols[11] = *(const V *)(transforms.stream(SoAPosZ) + i);
+
+    size_t lanes = std::min(width, n - i);
+    for (size_t l = 0; l < lanes; l++)
+    {
+      Mat4x4 &m = out[i + l];
+      for (int e = 0; e < 12; e++)
+      {
+        m.rc[e / 4][e % 4] = cols[e][l];
+      }
+      m.wx = 0.0f;
+      m.wy = 0.0f;
+      m.wz = 0.0f;
+      m.ww = 1.0f;
+    }
+  }
+}
+
+template <typename V, typename I>
+[[gnu::always_inline]] static inline void normalizeLanes(TransformSoA &transforms)
+{
+  float *rx = transforms.stream(SoARotX), *ry = transforms.stream(SoARotY);
+  float *rz = transforms.stream(SoARotZ), *rw = transforms.stream(SoARotW);
+
+  const size_t width = sizeof(V) / sizeof(float);
+  const size_t padded = transforms.paddedSize();
+  for (size_t i = 0; i < padded; i += width)
+  {
+    V x = *(V *)(rx + i), y = *(V *)(ry + i), z = *(V *)(rz + i), w = *(V *)(rw + i);
+    V lenSqrd = x * x + y * y + z * z + w * w;
+
+    // bit trick estimate of 1/sqrt refined by three newton steps, within a
+    // few ulp of 1/sqrt without a division or square root
+    V inv = (V)(0x5f375a86 - ((I)lenSqrd >> 1));
+    V half = 0.5f * lenSqrd;
+    inv = inv * (1.5f - half * inv * inv);
+    inv = inv * (1.5f - half * inv * inv);
+    inv = inv * (1.5f - half * inv * inv);
+
+    *(V *)(rx + i) = x * inv;
+    *(V *)(ry + i) = y * inv;
+    *(V *)(rz + i) = z * inv;
+    *(V *)(rw + i) = w * inv;
+  }
+}
+
+// both nlerp modes normalize with the bit trick 1/sqrt, the exact one with
+// one more newton step. QuatSlerp has no lane form, the rotations are left
+// alone for interpolateSoA to slerp joint by joint
+template <typename V, typename I, QuatInterp Mode>
+[[gnu::always_inline]] static inline void interpolateLanes(const TransformSoA &from, const TransformSoA &to, std::span<const float> t, TransformSoA &out)
+{
+  const size_t width = sizeof(V) / sizeof(float);
+  const size_t padded = out.paddedSize();
+  const SoAStream linear[] = {SoAPosX, SoAPosY, SoAPosZ, SoAScaleX, SoAScaleY, SoAScaleZ};
+
+  for (size_t i = 0; i < padded; i += width)
+  {
+    // t is not padded, the last group can read past its end and gets t = 0
+    // in the missing lanes
+    V tt = {};
+    if (i + width <= t.size())
+    {
+      __builtin_memcpy(&tt, t.data() + i, sizeof(V));
+    }
+    else if (i < t.size())
+    {
+      __builtin_memcpy(&tt, t.data() + i, (t.size() - i) * sizeof(float));
+    }
+
+    for (SoAStream s : linear)
+    {
+      V a = *(const V *)(from.stream(s) + i);
+      V b = *(const V *)(to.stream(s) + i);
+      *(V *)(out.stream(s) + i) = a + (b - a) * tt;
+    }
+    if constexpr (Mode == QuatSlerp)
+    {
+      continue;
+    }
+
+    V ax = *(const V *)(from.stream(SoARotX) + i), ay = *(const V *)(from.stream(SoARotY) + i);
+    V az = *(const V *)(from.stream(SoARotZ) + i), aw = *(const V *)(from.stream(SoARotW) + i);
+    V bx = *(const V *)(to.stream(SoARotX) + i), by = *(const V *)(to.stream(SoARotY) + i);
+    V bz = *(const V *)(to.stream(SoARotZ) + i), bw = *(const V *)(to.stream(SoARotW) + i);
+
+    V ca = ax * bx + ay * by + az * bz + aw * bw;
+    V ot = tt;
+    if constexpr (Mode == QuatFastNlerp)
+    {
+      // same correction as fastNlerp
+      V d = ca < 0.0f ? -ca : ca;
+      V a = 1.0904f + d * (-3.2452f + d * (3.55645f - d * 1.43519f));
+      V b = 0.848013f + d * (-1.06021f + d * 0.215638f);
+      V k = a * (tt - 0.5f) * (tt - 0.5f) + b;
+      ot = tt + tt * (tt - 0.5f) * (tt - 1.0f) * k;
+    }
+    V lt = 1.0f - ot;
+    V rt = ca < 0.0f ? -ot : ot;
+
+    V x = lt * ax + rt * bx, y = lt * ay + rt * by, z = lt * az + rt * bz, w = lt * aw + rt * bw;
+    V lenSqrd = x * x + y * y + z * z + w * w;
+
+    V inv = (V)(0x5f375a86 - ((I)lenSqrd >> 1));
+    V half = 0.5f * lenSqrd;
+    inv = inv * (1.5f - half * inv * inv);
+    inv = inv * (1.5f - half * inv * inv);
+    if constexpr (Mode != QuatFastNlerp)
+    {
+      inv = inv * (1.5f - half * inv * inv);
+    }
+
+    *(V *)(out.stream(SoARotX) + i) = x * inv;
+    *(V *)(out.stream(SoARotY) + i) = y * inv;
+    *(V *)(out.stream(SoARotZ) + i) = z * inv;
+    *(V *)(out.stream(SoARotW) + i) = w * inv;
+  }
+}
+
+static void combine4(const TransformSoA &parents, const TransformSoA &children, TransformSoA &out)
+{
+  combineLanes<float4v>(parents, children, out);
+}
+static void get4(const TransformSoA &transforms, std::span<Mat4x4> out) { getLanes<float4v>(transforms, out); }
+static void normalize4(TransformSoA &transforms) { normalizeLanes<float4v, int4v>(transforms); }
+static void interpolate4(const TransformSoA &from, const TransformSoA &to, std::span<const float> t, TransformSoA &out, QuatInterp mode)
+{
+  switch (mode)
+  {
+  case QuatFastNlerp:
+    interpolateLanes<float4v, int4v, QuatFastNlerp>(from, to, t, out);
+    break;
+  case QuatSlerp:
+    interpolateLanes<float4v, int4v, QuatSlerp>(from, to, t, out);
+    break;
+  default:
+    interpolateLanes<float4v, int4v, QuatNlerp>(from, to, t, out);
+    break;
+  }
+}
+
+#ifdef MATH_SIMD_X86
+#define AVX2 __attribute__((target("avx2,fma")))
+
+AVX2 static void combine8(const TransformSoA &parents, const TransformSoA &children, TransformSoA &out)
+{
+  combineLanes<float8v>(parents, children, out);
+}
+AVX2 static void get8(const TransformSoA &transforms, std::span<Mat4x4> out) { getLanes<float8v>(transforms, out); }
+AVX2 static void normalize8(TransformSoA &transforms) { normalizeLanes<float8v, int8v>(transforms); }
+AVX2 static void interpolate8(const TransformSoA &from, const TransformSoA &to, std::span<const float> t, TransformSoA &out, QuatInterp mode)
+{
+  switch (mode)
+  {
+  case QuatFastNlerp:
+    interpolateLanes<float8v, int8v, QuatFastNlerp>(from, to, t, out);
+    break;
+  case QuatSlerp:
+    interpolateLanes<float8v, int8v, QuatSlerp>(from, to, t, out);
+    break;
+  default:
+    interpolateLanes<float8v, int8v, QuatNlerp>(from, to, t, out);
+    break;
+  }
+}
+#endif
+
+// public entry points
+//________________________________________________________________________
+//________________________________________________________________________
+
+void combineSoA(const TransformSoA &parents, const TransformSoA &children, TransformSoA &out)
+{
+  combineSoA(parents, children, out, simdLevel());
+}
+
+void combineSoA(const TransformSoA &parents, const TransformSoA &children, TransformSoA &out, SimdLevel level)
+{
+  size_t n = std::min(parents.size(), children.size());
+  if (out.size() != n)
+  {
+    out.resize(n);
+  }
+
+#ifdef MATH_SIMD_X86
+  if (level >= SimdAVX2 && simdLevel() >= SimdAVX2)
+  {
+    combine8(parents, children, out);
+    return;
+  }
+#endif
+  combine4(parents, children, out);
+}
+
+void getSoA(const TransformSoA &transforms, std::span<Mat4x4> out)
+{
+  getSoA(transforms, out, simdLevel());
+}
+
+void getSoA(const TransformSoA &transforms, std::span<Mat4x4> out, SimdLevel level)
+{
+#ifdef MATH_SIMD_X86
+  if (level >= SimdAVX2 && simdLevel() >= SimdAVX2)
+  {
+    get8(transforms, out);
+    return;
+  }
+#endif
+  get4(transforms, out);
+}
+
+void normalizeSoA(TransformSoA &transforms)
+{
+  normalizeSoA(transforms, simdLevel());
+}
+
+void normalizeSoA(TransformSoA &transforms, SimdLevel level)
+{
+#ifdef MATH_SIMD_X86
+  if (level >= SimdAVX2 && simdLevel() >= SimdAVX2)
+  {
+    normalize8(transforms);
+    return;
+  }
+#endif
+  normalize4(transforms);
+}
+
+void interpolateSoA(const TransformSoA &from, const TransformSoA &to, std::span<const float> t, TransformSoA &out, QuatInterp mode)
+{
+  interpolateSoA(from, to, t, out, mode, simdLevel());
+}
+
+void interpolateSoA(const TransformSoA &from, const TransformSoA &to, std::span<const float> t, TransformSoA &out, QuatInterp mode, SimdLevel level)
+{
+  size_t n = std::min({from.size(), to.size(), t.size()});
+  if (out.size() != n)
+  {
+    out.resize(n);
+  }
+
+#ifdef MATH_SIMD_X86
+  if (level >= SimdAVX2 && simdLevel() >= SimdAVX2)
+  {
+    interpolate8(from, to, t, out, mode);
+  }
+  else
+#endif
+  {
+    interpolate4(from, to, t, out, mode);
+  }
+
+  if (mode != QuatSlerp)
+  {
+    return;
+  }
+  // the lane pass left the rotations alone. joint i only reads and writes
+  // its own rotation, so this is safe in place without a copy
+  for (size_t i = 0; i < n; i++)
+  {
+    Quat a(from.stream(SoARotX)[i], from.stream(SoARotY)[i], from.stream(SoARotZ)[i], from.stream(SoARotW)[i]);
+    Quat b(to.stream(SoARotX)[i], to.stream(SoARotY)[i], to.stream(SoARotZ)[i], to.stream(SoARotW)[i]);
+    Quat q = slerp(a, b, t[i]);
+    out.stream(SoARotX)[i] = q.x;
+    out.stream(SoARotY)[i] = q.y;
+    out.stream(SoARotZ)[i] = q.z;
+    out.stream(SoARotW)[i] = q.s;
+  }
+}
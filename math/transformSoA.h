@@ -0,0 +1,89 @@
+#ifndef TRANSFORM_SOA_H
+#define TRANSFORM_SOA_H
+
+#include "mat4.h"
+#include "simd.h"
+#include "transform.h"
+
+#include <span>
+#include <vector>
+
+// every stream is padded to a multiple of this, one avx register of floats
+#define SOA_LANES 8
+
+enum SoAStream
+{
+  SoAPosX,
+  SoAPosY,
+  SoAPosZ,
+  SoARotX,
+  SoARotY,
+  SoARotZ,
+  SoARotW,
+  SoAScaleX,
+  SoAScaleY,
+  SoAScaleZ,
+  SoAStreamCount,
+};
+
+/// @brief transforms stored as one 32 byte aligned float array per component
+/// (structure of arrays), so simd code can load the same component of 4 or 8
+/// joints with a single instruction. padding lanes hold identity transforms.
+class TransformSoA
+{
+public:
+  TransformSoA() : count(0), groups(0) {}
+  TransformSoA(size_t n);
+  ~TransformSoA() {}
+
+  void resize(size_t n);
+  size_t size() const;
+  /// @brief length of every stream including the padding
+  size_t paddedSize() const;
+
+  float *stream(SoAStream s);
+  const float *stream(SoAStream s) const;
+
+  Transform getTransform(size_t index) const;
+  void setTransform(size_t index, const Transform &transform);
+
+  /// @brief converts from/to the regular array of Transforms
+  void load(std::span<const Transform> transforms);
+  void store(std::span<Transform> out) const;
+
+private:
+  struct alignas(32) Lanes
+  {
+    float v[SOA_LANES];
+  };
+
+  std::vector<Lanes> data;
+  size_t count;
+  size_t groups;
+};
+
+/// @brief out[i] = combine(parents[i], children[i]) for every joint, out may
+/// be one of the inputs
+void combineSoA(const TransformSoA &parents, const TransformSoA &children, TransformSoA &out);
+
+/// @brief out[i] = transforms[i].get()
+void getSoA(const TransformSoA &transforms, std::span<Mat4x4> out);
+
+/// @brief out[i] = from[i] blended towards to[i] by t[i]. translation and
+/// scale are lerped, rotations use mode. t needs a value for every joint, out
+/// may be one of the inputs
+void interpolateSoA(const TransformSoA &from, const TransformSoA &to, std::span<const float> t, TransformSoA &out, QuatInterp mode);
+
+/// @brief normalizes every orientation in place
+void normalizeSoA(TransformSoA &transforms);
+
+// the above with the kernels of level instead of the cpu's, for comparing
+// both lane widths on one machine. 8 lanes for avx2 and 4 below it, levels
+// the cpu lacks fall back like mat4Kernels(level)
+
+void combineSoA(const TransformSoA &parents, const TransformSoA &children, TransformSoA &out, SimdLevel level);
+void getSoA(const TransformSoA &transforms, std::span<Mat4x4> out, SimdLevel level);
+void interpolateSoA(const TransformSoA &from, const TransformSoA &to, std::span<const float> t, TransformSoA &out, QuatInterp mode, SimdLevel level);
+void normalizeSoA(TransformSoA &transforms, SimdLevel level);
+
+#endif
@@ -1,15 +1,7 @@
 #include "utils.h"
 
-float to_radians(float degs)
-{
-  float radian = PIE / 180.0f;
-  return degs * radian;
-}
-float to_degrees(float rads)
-{
-  float scale = 180.0f / PIE;
-  return rads * scale;
-}
+#include <stdlib.h>
+
 // random float number generator
 float random_float() { return (float)(rand()) / (float)(RAND_MAX); }
 // random integer generator
@@ -32,28 +24,13 @@ float random_float(int a, int b)
     return b;
   return (float)(random_int(a, b)) + random_float();
 }
-// return the the largest of the two floats
-float max(float a, float b) { return a < b ? b : a; }
-// return the smallest of the two floats
-float min(float a, float b) { return a < b ? a : b; }
 
-int step(float edge, float b) { return b > edge ? 1 : 0; }
-
-float fract(float value) { return value - floor(value); }
-
-template <class T>
-T clamp(T v, T min, T max)
-{
-  if (v < min)
-  {
-    return min;
-  }
-  if (v > max)
-  {
-    return max;
-  }
-  return v;
-  // return std::max(min, std::min(max, v));
-}
-template float clamp<float>(float v, float min, float max);
-template int clamp<int>(int v, int min, int max);
\ No newline at end of file
+static_assert(to_degrees(to_radians(90.0f)) == 90.0f);
+static_assert(clamp(5, 0, 3) == 3 && clamp(-1.0f, 0.0f, 1.0f) == 0.0f);
+static_assert(fract(2.25f) == 0.25f);
+static_assert(cx_fabs(fast_inv_sqrt(0.25f) - 2.0f) < 0.00001f);
+static_assert(cx_sqrt(25.0f) == 5.0f && cx_sqrt(2.0f) == 1.41421356f);
+static_assert(cx_floor(-1.5f) == -2.0f && cx_floor(3.0f) == 3.0f);
+static_assert(cx_fabs(cx_sin(PIE / 6.0f) - 0.5f) < 1e-6f && cx_fabs(cx_cos(-PIE) + 1.0f) < 1e-6f);
+static_assert(cx_fabs(cx_acos(-1.0f) - 3.14159265f) < 1e-6f && cx_acos(1.0f) == 0.0f);
+static_assert(cx_copysign(2.0f, -0.0f) == -2.0f && cx_fabs(-3.0f) == 3.0f);
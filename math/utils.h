@@ -1,24 +1,203 @@
 #ifndef MATH_UTILS_H
 #define MATH_UTILS_H
 
+#include <bit>
+#include <limits>
 #include <math.h>
+#include <stdint.h>
 
 #define PIE 3.141592f
 #define VEC3_EPSILON 0.000001f
 
 // convert degrees to radians
-float to_radians(float degs);
+constexpr float to_radians(float degs)
+{
+  float radian = PIE / 180.0f;
+  return degs * radian;
+}
 // convert radians to degrees
-float to_degrees(float rads);
+constexpr float to_degrees(float rads)
+{
+  float scale = 180.0f / PIE;
+  return rads * scale;
+}
 float random_float();
 float random_float(int a, int b);
 int random_int(int a, int b);
-float max(float a, float b);
-float min(float a, float b);
-int step(float edge, float b);
-float fract(float value);
+// return the the largest of the two floats
+constexpr float max(float a, float b) { return a < b ? b : a; }
+// return the smallest of the two floats
+constexpr float min(float a, float b) { return a < b ? a : b; }
+constexpr int step(float edge, float b) { return b > edge ? 1 : 0; }
+
+// constexpr math. only gcc evaluates sin, sqrt and the rest of <math.h> in
+// constant expressions, the cx_ functions run a series of their own there
+// and the libm function at run time. the series are exact to float
+// precision, a compile time result may still differ from libm in the last bit
+namespace UtilsHelpers
+{
+  constexpr double PI = 3.14159265358979323846;
+
+  // newton steps from above, until they stop shrinking
+  constexpr double sqrtSeries(double value)
+  {
+    if (value == 0.0 || value == std::numeric_limits<double>::infinity())
+    {
+      return value;
+    }
+    if (!(value > 0.0))
+    {
+      return std::numeric_limits<double>::quiet_NaN();
+    }
+    double root = value > 1.0 ? value : 1.0;
+    while (true)
+    {
+      double next = 0.5 * (root + value / root);
+      if (next >= root)
+      {
+        return root;
+      }
+      root = next;
+    }
+  }
+
+  // taylor series on x moved to [-pi, pi]
+  constexpr double sinSeries(double x)
+  {
+    double turns = x / (2.0 * PI);
+    x -= 2.0 * PI * (double)(int64_t)(turns + (turns < 0.0 ? -0.5 : 0.5));
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 16; n++)
+    {
+      term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+      sum += term;
+    }
+    return sum;
+  }
+  constexpr double cosSeries(double x) { return sinSeries(x + PI / 2.0); }
+
+  // taylor series, quick for |x| <= 0.5 where each term is under a quarter
+  // of the one before
+  constexpr double asinSeries(double x)
+  {
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 30; n++)
+    {
+      term *= x * x * (2.0 * n - 1.0) * (2.0 * n - 1.0) / ((2.0 * n) * (2.0 * n + 1.0));
+      sum += term;
+    }
+    return sum;
+  }
+  // the ends go through acos(x) = 2 asin(sqrt((1 - x) / 2))
+  constexpr double acosSeries(double x)
+  {
+    if (!(x >= -1.0 && x <= 1.0))
+    {
+      return std::numeric_limits<double>::quiet_NaN();
+    }
+    if (x > 0.5)
+    {
+      return 2.0 * asinSeries(sqrtSeries((1.0 - x) / 2.0));
+    }
+    if (x < -0.5)
+    {
+      return PI - 2.0 * asinSeries(sqrtSeries((1.0 + x) / 2.0));
+    }
+    return PI / 2.0 - asinSeries(x);
+  }
+}; // namespace UtilsHelpers
+
+constexpr float cx_sqrt(float value)
+{
+  if consteval
+  {
+    return (float)UtilsHelpers::sqrtSeries(value);
+  }
+  return sqrtf(value);
+}
+constexpr float cx_sin(float rads)
+{
+  if consteval
+  {
+    return (float)UtilsHelpers::sinSeries(rads);
+  }
+  return sinf(rads);
+}
+constexpr float cx_cos(float rads)
+{
+  if consteval
+  {
+    return (float)UtilsHelpers::cosSeries(rads);
+  }
+  return cosf(rads);
+}
+constexpr float cx_tan(float rads)
+{
+  if consteval
+  {
+    return (float)(UtilsHelpers::sinSeries(rads) / UtilsHelpers::cosSeries(rads));
+  }
+  return tanf(rads);
+}
+constexpr float cx_acos(float value)
+{
+  if consteval
+  {
+    return (float)UtilsHelpers::acosSeries(value);
+  }
+  return acosf(value);
+}
+constexpr float cx_floor(float value)
+{
+  if consteval
+  {
+    // from 2^23 on every float is whole
+    if (!(value > -8388608.0f && value < 8388608.0f))
+    {
+      return value;
+    }
+    float whole = (float)(int32_t)value;
+    return whole > value ? whole - 1.0f : whole;
+  }
+  return floorf(value);
+}
+// sign bit operations, constant in any compiler as they are
+constexpr float cx_fabs(float value)
+{
+  return std::bit_cast<float>(std::bit_cast<uint32_t>(value) & 0x7fffffffu);
+}
+constexpr float cx_copysign(float magnitude, float sign)
+{
+  return std::bit_cast<float>((std::bit_cast<uint32_t>(magnitude) & 0x7fffffffu) |
+                              (std::bit_cast<uint32_t>(sign) & 0x80000000u));
+}
+
+constexpr float fract(float value) { return value - cx_floor(value); }
+// approximate 1 / sqrt(value) for positive values, bit trick estimate plus
+// two newton steps, relative error below 5e-6
+constexpr float fast_inv_sqrt(float value)
+{
+  float inv = std::bit_cast<float>(0x5f375a86 - (std::bit_cast<uint32_t>(value) >> 1));
+  float half = 0.5f * value;
+  inv = inv * (1.5f - half * inv * inv);
+  inv = inv * (1.5f - half * inv * inv);
+  return inv;
+}
 // limits a value to the range min - max
 template <class T>
-T clamp(T v, T min, T max);
+constexpr T clamp(T v, T min, T max)
+{
+  if (v < min)
+  {
+    return min;
+  }
+  if (v > max)
+  {
+    return max;
+  }
+  return v;
+}
 
-#endif
\ No newline at end of file
+#endif
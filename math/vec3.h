@@ -24,36 +24,36 @@ struct Vector3f
     float v[4];
   };
   /// @brief default constructor with components set to 0.0
-  Vector3f() : x(0.0f), y(0.0f), z(0.0f) {}
+  constexpr Vector3f() : x(0.0f), y(0.0f), z(0.0f) {}
   /// @brief set all components to a single value
-  Vector3f(float _v) : x(_v), y(_v), z(_v) {}
+  constexpr Vector3f(float _v) : x(_v), y(_v), z(_v) {}
   /// @brief use a simple array to set components
-  Vector3f(float *fv) : x(fv[0]), y(fv[1]), z(fv[2]) {}
+  constexpr Vector3f(float *fv) : x(fv[0]), y(fv[1]), z(fv[2]) {}
   /// @brief set each components idividually
-  Vector3f(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
+  constexpr Vector3f(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
 
-  Vector3f operator+=(const Vector3f &r)
+  constexpr Vector3f operator+=(const Vector3f &r)
   {
     this->x += r.x;
     this->y += r.y;
     this->z += r.z;
     return *this;
   }
-  Vector3f operator-=(const Vector3f &r)
+  constexpr Vector3f operator-=(const Vector3f &r)
   {
     this->x -= r.x;
     this->y -= r.y;
     this->z -= r.z;
     return *this;
   }
-  Vector3f operator*=(float r)
+  constexpr Vector3f operator*=(float r)
   {
     this->x *= r;
     this->y *= r;
     this->z *= r;
     return *this;
   }
-  Vector3f operator/=(float r)
+  constexpr Vector3f operator/=(float r)
   {
     this->x /= r;
     this->y /= r;
@@ -62,39 +62,83 @@ struct Vector3f
   }
 
   // get the vectors/points length
-  float mag() const;
-  float magSqrd() const;
+  constexpr float mag() const { return cx_sqrt(this->magSqrd()); }
+  constexpr float magSqrd() const
+  {
+    return this->x * this->x + this->y * this->y + this->z * this->z;
+  }
   // normalize vec3 to have unit length
-  Vector3f unit() const;
+  constexpr Vector3f unit() const
+  {
+    float invMag = 1.0f / this->mag();
+
+    return Vector3f(
+        invMag * this->x,
+        invMag * this->y,
+        invMag * this->z);
+  }
 };
 // point 3D
 typedef Vector3f Point3f;
 // for difining colors
 typedef Vector3f Color3f;
 
+// miltiplication
+constexpr Vector3f operator*(const Vector3f &l, float r) { return Vector3f(l.x * r, l.y * r, l.z * r); }
+constexpr Vector3f operator*(float r, const Vector3f &l) { return Vector3f(l.x * r, l.y * r, l.z * r); }
+constexpr Vector3f operator*(const Vector3f &lhs, const Vector3f &rhs)
+{
+  return Vector3f(lhs.x * rhs.x, lhs.y * rhs.y, lhs.z * rhs.z);
+}
+// addition
+constexpr Vector3f operator+(const Vector3f &l, const Vector3f &r)
+{
+  return Vector3f(l.x + r.x, l.y + r.y, l.z + r.z);
+}
+// subtraction
+constexpr Vector3f operator-(const Vector3f &l, const Vector3f &r)
+{
+  return Vector3f(l.x - r.x, l.y - r.y, l.z - r.z);
+}
+// comparisons
+constexpr bool operator==(const Vector3f &l, const Vector3f &r)
+{
+  return (l.x == r.x) && (l.y == r.y) && (l.z == r.z);
+}
+constexpr bool operator!=(const Vector3f &l, const Vector3f &r) { return !(l == r); }
+
 // get the dot product between two 3D vectors
-float dot(const Vector3f &p1, const Vector3f &p2);
+constexpr float dot(const Vector3f &p1, const Vector3f &p2)
+{
+  return (p1.x * p2.x) + (p1.y * p2.y) + (p1.z * p2.z);
+}
 
 // get the cross product between two 3D vectors
-Vector3f cross(const Vector3f &v1, const Vector3f &v2);
+constexpr Vector3f cross(const Vector3f &p1, const Vector3f &p2)
+{
+  return Vector3f(
+      p1.y * p2.z - p1.z * p2.y,
+      p1.z * p2.x - p1.x * p2.z,
+      p1.x * p2.y - p1.y * p2.x);
+}
 
 // reflect vector around normal
-Vector3f reflect(const Vector3f &v, const Vector3f &n);
+constexpr Vector3f reflect(const Vector3f &v, const Vector3f &n)
+{
+  Vector3f v_new = -2.0f * n * dot(n, v) + v;
+  return v_new;
+}
 // limit to min and max value
-Vector3f clamp(const Vector3f &v, const Vector3f &min, const Vector3f &max);
+constexpr Vector3f clamp(const Vector3f &v, const Vector3f &min, const Vector3f &max)
+{
+  Vector3f v_new = v;
+  v_new.x = clamp(v_new.x, min.x, max.x);
+  v_new.y = clamp(v_new.y, min.y, max.y);
+  v_new.z = clamp(v_new.z, min.z, max.z);
 
-Vector3f lerp(Vector3f a, Vector3f b, float c);
+  return v_new;
+}
 
-// miltiplication
-Vector3f operator*(const Vector3f &l, float r);
-Vector3f operator*(float l, const Vector3f &r);
-Vector3f operator*(const Vector3f &lhs, const Vector3f &rhs);
-// addition
-Vector3f operator+(const Vector3f &l, const Vector3f &r);
-// subtraction
-Vector3f operator-(const Vector3f &l, const Vector3f &r);
-// comparisons
-bool operator==(const Vector3f &l, const Vector3f &r);
-bool operator!=(const Vector3f &l, const Vector3f &r);
+constexpr Vector3f lerp(Vector3f a, Vector3f b, float c) { return (1.0f - c) * a + c * b; }
 
 #endif
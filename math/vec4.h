@@ -26,31 +26,93 @@ struct Vector4f
     float v[4];
   };
   // default constuctor
-  inline Vector4f()
+  constexpr Vector4f()
       : x(0.0), y(0.0), z(0.0), w(0.0) {}
   // set all components to a singular value
-  inline Vector4f(float _v)
+  constexpr Vector4f(float _v)
       : x(_v), y(_v), z(_v), w(_v) {}
   // set each value individialy
-  inline Vector4f(float _x, float _y, float _z, float _w)
+  constexpr Vector4f(float _x, float _y, float _z, float _w)
       : x(_x), y(_y), z(_z), w(_w) {}
   // set the 4d vector using an array
-  inline Vector4f(float *_v)
+  constexpr Vector4f(float *_v)
       : x(_v[0]), y(_v[1]), z(_v[2]), w(_v[3]) {}
 
-  Vector4f unit() const;
-  float mag() const;
+  constexpr Vector4f unit() const;
+  constexpr float mag() const
+  {
+    float x2 = this->x * this->x;
+    float y2 = this->y * this->y;
+    float z2 = this->z * this->z;
+    float w2 = this->w * this->w;
+
+    return cx_sqrt(x2 + y2 + z2 + w2);
+  }
 };
 
 typedef Vector4f color4f;
 
-float dot(const Vector4f &l, const Vector4f &r);
+constexpr float dot(const Vector4f &l, const Vector4f &r)
+{
+  return l.x * r.x + l.y * r.y + l.z * r.z + l.w * r.w;
+}
 
-Vector4f operator+(const Vector4f &l, const Vector4f &r);
-Vector4f operator-(const Vector4f &l, const Vector4f &r);
+constexpr Vector4f operator+(const Vector4f &l, const Vector4f &r)
+{
+  return Vector4f(
+      l.x + r.x,
+      l.y + r.y,
+      l.z + r.z,
+      l.w + r.w);
+}
+constexpr Vector4f operator-(const Vector4f &l, const Vector4f &r)
+{
+  return Vector4f(
+      l.x - r.x,
+      l.y - r.y,
+      l.z - r.z,
+      l.w - r.w);
+}
+
+constexpr Vector4f operator*(const Vector4f &l, const Vector4f &r)
+{
+  return Vector4f(
+      l.x * r.x,
+      l.y * r.y,
+      l.z * r.z,
+      l.w * r.w);
+}
+constexpr Vector4f operator*(const Vector4f &l, float r)
+{
+  return Vector4f(
+      l.x * r,
+      l.y * r,
+      l.z * r,
+      l.w * r);
+}
+constexpr Vector4f operator*(float l, const Vector4f &r)
+{
+  return Vector4f(
+      l * r.x,
+      l * r.y,
+      l * r.z,
+      l * r.w);
+}
+
+constexpr bool operator==(const Vector4f &l, const Vector4f &r)
+{
+  return (l.x == r.x) && (l.y == r.y) && (l.z == r.z) && (l.w == r.w);
+}
+
+constexpr Vector4f Vector4f::unit() const
+{
+  float invMag = 1.0 / this->mag();
 
-Vector4f operator*(const Vector4f &l, const Vector4f &r);
-Vector4f operator*(const Vector4f &l, float r);
-Vector4f operator*(float l, const Vector4f &r);
+  return Vector4f(
+      this->x * invMag,
+      this->y * invMag,
+      this->z * invMag,
+      this->w * invMag);
+}
 
 #endif
@@ -1,3 +1,4 @@
+#include "blending.h"
 #include "clip.h"
 #include "frame.h"
 #include "pose.h"
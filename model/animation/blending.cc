@@ -0,0 +1,162 @@
+#include "blending.h"
+
+#include <algorithm>
+
+namespace BlendHelpers
+{
+  inline float maskAt(std::span<const float> mask, size_t joint)
+  {
+    return joint < mask.size() ? mask[joint] : 0.0f;
+  }
+
+  inline Transform blend(const Transform &a, const Transform &b, float t)
+  {
+    Transform result;
+    result.translation = lerp(a.translation, b.translation, t);
+    result.orientation = nlerp(a.orientation, b.orientation, t);
+    result.scaling = lerp(a.scaling, b.scaling, t);
+    return result;
+  }
+
+  inline Transform add(const Transform &pose, const Transform &additive, float weight)
+  {
+    Transform result;
+    result.translation = pose.translation + additive.translation * weight;
+    result.orientation = pose.orientation * nlerp(Quat(), additive.orientation, weight);
+    result.scaling = pose.scaling + additive.scaling * weight;
+    return result;
+  }
+}; // namespace BlendHelpers
+
+void blendPose(Pose &out, Pose &a, Pose &b, float t)
+{
+  std::span<Transform> result = out.getLocalTransforms();
+  std::span<Transform> from = a.getLocalTransforms();
+  std::span<Transform> to = b.getLocalTransforms();
+
+  size_t n = std::min({result.size(), from.size(), to.size()});
+  for (size_t i = 0; i < n; i++)
+  {
+    result[i] = BlendHelpers::blend(from[i], to[i], t);
+  }
+}
+
+void blendPose(Pose &out, Pose &a, Pose &b, float t, std::span<const float> mask)
+{
+  std::span<Transform> result = out.getLocalTransforms();
+  std::span<Transform> from = a.getLocalTransforms();
+  std::span<Transform> to = b.getLocalTransforms();
+
+  size_t n = std::min({result.size(), from.size(), to.size()});
+  for (size_t i = 0; i < n; i++)
+  {
+    float weight = t * BlendHelpers::maskAt(mask, i);
+    if (weight > 0.0f)
+    {
+      result[i] = BlendHelpers::blend(from[i], to[i], weight);
+    }
+    else if (&out != &a)
+    {
+      result[i] = from[i];
+    }
+  }
+}
+
+void makeAdditivePose(Pose &out, Pose &pose, Pose &base)
+{
+  std::span<Transform> result = out.getLocalTransforms();
+  std::span<Transform> animated = pose.getLocalTransforms();
+  std::span<Transform> reference = base.getLocalTransforms();
+
+  size_t n = std::min({result.size(), animated.size(), reference.size()});
+  for (size_t i = 0; i < n; i++)
+  {
+    Transform difference;
+    difference.translation = animated[i].translation - reference[i].translation;
+    difference.orientation = (reference[i].orientation.conjugate() * animated[i].orientation).unit();
+    difference.scaling = animated[i].scaling - reference[i].scaling;
+    result[i] = difference;
+  }
+}
+
+void addPose(Pose &out, Pose &pose, Pose &additive, float weight)
+{
+  std::span<Transform> result = out.getLocalTransforms();
+  std::span<Transform> base = pose.getLocalTransforms();
+  std::span<Transform> difference = additive.getLocalTransforms();
+
+  size_t n = std::min({result.size(), base.size(), difference.size()});
+  for (size_t i = 0; i < n; i++)
+  {
+    result[i] = BlendHelpers::add(base[i], difference[i], weight);
+  }
+}
+
+void addPose(Pose &out, Pose &pose, Pose &additive, float weight, std::span<const float> mask)
+{
+  std::span<Transform> result = out.getLocalTransforms();
+  std::span<Transform> base = pose.getLocalTransforms();
+  std::span<Transform> difference = additive.getLocalTransforms();
+
+  size_t n = std::min({result.size(), base.size(), difference.size()});
+  for (size_t i = 0; i < n; i++)
+  {
+    float w = weight * BlendHelpers::maskAt(mask, i);
+    if (w > 0.0f)
+    {
+      result[i] = BlendHelpers::add(base[i], difference[i], w);
+    }
+    else if (&out != &pose)
+    {
+      result[i] = base[i];
+    }
+  }
+}
+
+void subtreeMask(Pose &pose, size_t root, std::vector<float> &out)
+{
+  size_t size = pose.size();
+  out.assign(size, 0.0f);
+
+  for (size_t i = 0; i < size; i++)
+  {
+    // walk up until root or the top, bounded in case of a parent cycle
+    int joint = (int)i;
+    for (size_t depth = 0; joint != -1 && depth <= size; depth++)
+    {
+      if ((size_t)joint == root)
+      {
+        out[i] = 1.0f;
+        break;
+      }
+      joint = pose.getParent((size_t)joint);
+    }
+  }
+}
+
+// pool
+//________________________________________________________________________
+//________________________________________________________________________
+
+Pose &PosePool::acquire(const Pose &like)
+{
+  Pose *pose = nullptr;
+  if (this->unused.empty())
+  {
+    pose = &this->poses.emplace_back();
+  }
+  else
+  {
+    pose = this->unused.back();
+    this->unused.pop_back();
+  }
+
+  // same sized poses copy without allocating
+  *pose = like;
+  return *pose;
+}
+
+void PosePool::release(Pose &pose)
+{
+  this->unused.push_back(&pose);
+}
@@ -0,0 +1,72 @@
+#ifndef BLENDING_H
+#define BLENDING_H
+
+#include "clip.h"
+#include "pose.h"
+
+#include <deque>
+#include <span>
+#include <vector>
+
+// pose blending. every function works joint by joint on local transforms and
+// writes to a pose the caller owns, out may be one of the inputs. masks hold
+// one weight per joint, joints past the end of a mask get 0.
+
+/// @brief out = a blended towards b by t. translation and scale are lerped,
+/// rotations nlerped
+void blendPose(Pose &out, Pose &a, Pose &b, float t);
+/// @brief same with t scaled per joint by mask, for partial body blends
+void blendPose(Pose &out, Pose &a, Pose &b, float t, std::span<const float> mask);
+
+/// @brief out = the difference from base to pose, what addPose applies.
+/// rotation base^-1 * pose, translation and scale pose - base
+void makeAdditivePose(Pose &out, Pose &pose, Pose &base);
+/// @brief out = pose with additive on top, scaled by weight (1 = all of it)
+void addPose(Pose &out, Pose &pose, Pose &additive, float weight);
+void addPose(Pose &out, Pose &pose, Pose &additive, float weight, std::span<const float> mask);
+
+/// @brief mask of 1 for root and every joint below it, 0 elsewhere. out is
+/// resized to the pose
+void subtreeMask(Pose &pose, size_t root, std::vector<float> &out);
+
+/// @brief scratch poses for blend trees. acquire hands out a pose shaped like
+/// the given one, reusing released poses, so a tree that needs the same
+/// number of temporaries every frame stops allocating after the first
+class PosePool
+{
+public:
+  PosePool() {}
+  ~PosePool() {}
+
+  /// @brief a copy of like, valid until released or the pool is destroyed
+  Pose &acquire(const Pose &like);
+  void release(Pose &pose);
+
+private:
+  // deque keeps handed out poses in place when the pool grows
+  std::deque<Pose> poses;
+  std::vector<Pose *> unused;
+};
+
+/// @brief a clip played on top of the base animation
+struct AnimationLayer
+{
+  AnimationLayer() : clip(-1), weight(1.0f), additive(false), referenceClip(-1) {}
+
+  int clip;
+  float weight;
+  /// @brief added to the pose below (relative to the clip's first frame)
+  /// instead of blended with it
+  bool additive;
+  /// @brief per joint weights, empty for the whole body
+  std::vector<float> mask;
+
+  ClipCursor cursor;
+  /// @brief additive reference, the clip at its start time. filled on first
+  /// use and again whenever clip changes
+  Pose reference;
+  /// @brief the clip reference was sampled from, -1 before the first use
+  int referenceClip;
+};
+
+#endif
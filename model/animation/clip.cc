@@ -3,9 +3,71 @@
 #include "pose.h"
 #include "transformTrack.h"
 
-Clip::Clip() : name("none"), startTime(0.0), endTime(0.0), looping(true) {}
+#include <algorithm>
+#include <cassert>
+
+namespace StaticHelpers
+{
+  inline bool near(const float *a, const float *b, size_t n, float tolerance)
+  {
+    for (size_t i = 0; i < n; i++)
+    {
+      if (fabsf(a[i] - b[i]) > tolerance)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// @brief q and -q are the same rotation
+  template <size_t N>
+  inline bool same(const float *a, const float *b, float tolerance)
+  {
+    if (near(a, b, N, tolerance))
+    {
+      return true;
+    }
+    if constexpr (N == 4)
+    {
+      float negated[4] = {-b[0], -b[1], -b[2], -b[3]};
+      return near(a, negated, 4, tolerance);
+    }
+    return false;
+  }
+
+  /// @brief every key holds the first key's value. cubic keys also need
+  /// flat tangents or the curve would leave the value between keys
+  template <typename T, size_t N>
+  inline bool isConstant(Track<T, N> &track, float tolerance)
+  {
+    const float zero[N] = {};
+    Frame<N> &first = track.frames[0];
+    for (Frame<N> &frame : track.frames)
+    {
+      if (!same<N>(frame.m_value, first.m_value, tolerance))
+      {
+        return false;
+      }
+      if (track.interpolation == Cubic &&
+          !(near(frame.m_in, zero, N, tolerance) && near(frame.m_out, zero, N, tolerance)))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+}; // namespace StaticHelpers
+
+Clip::Clip() : name("none"), startTime(0.0), endTime(0.0), looping(true), grouped(true) {}
 
 float Clip::sample(Pose &outPose, float inTime)
+{
+  ClipCursor cursor;
+  return this->sample(outPose, inTime, cursor);
+}
+
+float Clip::sample(Pose &outPose, float inTime, ClipCursor &cursor, std::span<const uint8_t> active)
 {
   if (this->GetDuration() == 0.0)
   {
@@ -15,17 +77,326 @@ float Clip::sample(Pose &outPose, float inTime)
   float time = inTime;
   time = this->adjustTimeToFitRange(time);
 
+  if (!this->constants.empty())
+  {
+    this->applyConstants(outPose);
+  }
+
+  if (!this->packed.empty())
+  {
+    this->packed.sample(outPose, time);
+    return time;
+  }
+  if (!this->compressed.empty())
+  {
+    this->compressed.sample(outPose, time, cursor);
+    return time;
+  }
+
   uint size = this->tracks.size();
-  for (uint i = 0; i < size; ++i)
+  if (cursor.tracks.size() != size)
+  {
+    cursor.tracks.resize(size);
+  }
+  // regrouping here would write to a clip other threads sample, see
+  // getTracks
+  assert(this->grouped);
+
+  std::span<Transform> locals = outPose.getLocalTransforms();
+  if (active.empty())
+  {
+    this->sampleGroups<Constant>(locals, time, cursor);
+    this->sampleGroups<Linear>(locals, time, cursor);
+    this->sampleGroups<Cubic>(locals, time, cursor);
+  }
+  else
   {
-    uint j = (uint)this->tracks[i].getId();
-    Transform local = outPose.getLocalTransform((size_t)j);
-    Transform animated = this->tracks[i].sample(local, time, this->looping);
-    outPose.setLocalTransform((size_t)j, animated);
+    this->sampleGroups<Constant, true>(locals, time, cursor, active);
+    this->sampleGroups<Linear, true>(locals, time, cursor, active);
+    this->sampleGroups<Cubic, true>(locals, time, cursor, active);
   }
   return time;
 }
 
+void Clip::sample(std::span<Pose> outPoses, std::span<const float> inTimes, ClipBatch &batch)
+{
+  size_t count = std::min(outPoses.size(), inTimes.size());
+  batch.times.resize(count);
+  batch.order.resize(count);
+  batch.cursors.resize(count);
+  if (this->GetDuration() == 0.0)
+  {
+    std::fill(batch.times.begin(), batch.times.end(), 0.0f);
+    return;
+  }
+
+  for (size_t k = 0; k < count; k++)
+  {
+    batch.times[k] = this->adjustTimeToFitRange(inTimes[k]);
+    batch.order[k] = (uint)k;
+  }
+  // ties by index so the same pose samples for its group every frame and
+  // keeps a current cursor
+  std::sort(batch.order.begin(), batch.order.end(), [&batch](uint a, uint b)
+            { return batch.times[a] < batch.times[b] || (batch.times[a] == batch.times[b] && a < b); });
+
+  if (!this->constants.empty())
+  {
+    for (size_t k = 0; k < count; k++)
+    {
+      this->applyConstants(outPoses[k]);
+    }
+  }
+
+  if (!this->packed.empty())
+  {
+    for (uint k : batch.order)
+    {
+      this->packed.sample(outPoses[k], batch.times[k]);
+    }
+    return;
+  }
+  if (!this->compressed.empty())
+  {
+    for (uint k : batch.order)
+    {
+      this->compressed.sample(outPoses[k], batch.times[k], batch.cursors[k]);
+    }
+    return;
+  }
+
+  uint size = this->tracks.size();
+  for (ClipCursor &cursor : batch.cursors)
+  {
+    if (cursor.tracks.size() != size)
+    {
+      cursor.tracks.resize(size);
+    }
+  }
+  assert(this->grouped);
+
+  for (size_t j = 0; j < count;)
+  {
+    uint k = batch.order[j];
+    float time = batch.times[k];
+    std::span<Transform> locals = outPoses[k].getLocalTransforms();
+    this->sampleGroups<Constant>(locals, time, batch.cursors[k]);
+    this->sampleGroups<Linear>(locals, time, batch.cursors[k]);
+    this->sampleGroups<Cubic>(locals, time, batch.cursors[k]);
+
+    // the rest of the poses at this time copy what was sampled, their
+    // cursors are not used while they keep sharing a time with k
+    for (j++; j < count && batch.times[batch.order[j]] == time; j++)
+    {
+      this->copyGroups(locals, outPoses[batch.order[j]].getLocalTransforms());
+    }
+  }
+}
+
+void Clip::copyGroups(std::span<Transform> from, std::span<Transform> to)
+{
+  for (auto &group : this->groups[0])
+  {
+    for (uint i : group)
+    {
+      size_t id = this->tracks[i].getId();
+      to[id].translation = from[id].translation;
+    }
+  }
+  for (auto &group : this->groups[1])
+  {
+    for (uint i : group)
+    {
+      size_t id = this->tracks[i].getId();
+      to[id].orientation = from[id].orientation;
+    }
+  }
+  for (auto &group : this->groups[2])
+  {
+    for (uint i : group)
+    {
+      size_t id = this->tracks[i].getId();
+      to[id].scaling = from[id].scaling;
+    }
+  }
+}
+
+template <Interpolation I, bool Masked>
+void Clip::sampleGroups(std::span<Transform> locals, float time, ClipCursor &cursor, std::span<const uint8_t> active)
+{
+  // joints past the end of the mask are sampled
+  auto skip = [&active](size_t id)
+  {
+    return Masked && id < active.size() && !active[id];
+  };
+
+  for (uint i : this->groups[0][I])
+  {
+    TransformTrack &track = this->tracks[i];
+    if (skip(track.getId()))
+    {
+      continue;
+    }
+    locals[track.getId()].translation = track.getPosTrack().sampleMode<I>(time, this->looping, cursor.tracks[i].position);
+  }
+  for (uint i : this->groups[1][I])
+  {
+    TransformTrack &track = this->tracks[i];
+    if (skip(track.getId()))
+    {
+      continue;
+    }
+    locals[track.getId()].orientation = track.getRotationTrack().sampleMode<I>(time, this->looping, cursor.tracks[i].rotation);
+  }
+  for (uint i : this->groups[2][I])
+  {
+    TransformTrack &track = this->tracks[i];
+    if (skip(track.getId()))
+    {
+      continue;
+    }
+    locals[track.getId()].scaling = track.getScalingTrack().sampleMode<I>(time, this->looping, cursor.tracks[i].scaling);
+  }
+}
+
+void Clip::applyConstants(Pose &outPose)
+{
+  std::span<Transform> locals = outPose.getLocalTransforms();
+  for (ConstantJoint &joint : this->constants)
+  {
+    Transform &local = locals[joint.id];
+    if (joint.channels & PackedPosition)
+    {
+      local.translation = joint.value.translation;
+    }
+    if (joint.channels & PackedRotation)
+    {
+      local.orientation = joint.value.orientation;
+    }
+    if (joint.channels & PackedScale)
+    {
+      local.scaling = joint.value.scaling;
+    }
+  }
+}
+
+StaticReport Clip::removeStaticChannels(Pose &restPose, float tolerance)
+{
+  StaticReport report = {0, 0, 0, 0, 0};
+  this->constants.clear();
+
+  // returns true when the channel was taken out of the track
+  auto strip = [&](auto &channel, const float *rest, uint8_t bit, ConstantJoint &constant, float *value)
+  {
+    constexpr size_t n = sizeof(channel.frames[0].m_value) / sizeof(float);
+    if (channel.size() == 0)
+    {
+      return false;
+    }
+    report.channelsBefore++;
+    if (channel.size() > 1 && !StaticHelpers::isConstant(channel, tolerance))
+    {
+      return false;
+    }
+
+    // sample never reads single key channels, they go like rest channels
+    if (channel.size() == 1 || StaticHelpers::same<n>(channel.frames[0].m_value, rest, tolerance))
+    {
+      report.restChannels++;
+    }
+    else
+    {
+      report.constantChannels++;
+      constant.channels |= bit;
+      for (size_t i = 0; i < n; i++)
+      {
+        value[i] = channel.frames[0].m_value[i];
+      }
+    }
+    channel.frames.clear();
+    return true;
+  };
+
+  std::vector<TransformTrack> kept;
+  kept.reserve(this->tracks.size());
+  for (TransformTrack &track : this->tracks)
+  {
+    size_t id = track.getId();
+    Transform rest = restPose.getLocalTransform(id);
+    ConstantJoint constant = {id, 0, rest};
+
+    strip(track.getPosTrack(), rest.translation.v, PackedPosition, constant, constant.value.translation.v);
+    strip(track.getRotationTrack(), rest.orientation.v, PackedRotation, constant, constant.value.orientation.v);
+    strip(track.getScalingTrack(), rest.scaling.v, PackedScale, constant, constant.value.scaling.v);
+
+    if (constant.channels != 0)
+    {
+      this->constants.push_back(constant);
+    }
+    if (track.getPosTrack().size() > 1 || track.getRotationTrack().size() > 1 || track.getScalingTrack().size() > 1)
+    {
+      kept.push_back(track);
+    }
+    else
+    {
+      report.tracksRemoved++;
+    }
+  }
+  this->tracks.swap(kept);
+  // the clip keeps its duration, it is not recalculated from what is left
+  this->regroup();
+
+  this->staticJoints.assign(restPose.size(), true);
+  for (TransformTrack &track : this->tracks)
+  {
+    this->staticJoints[track.getId()] = false;
+  }
+  for (ConstantJoint &constant : this->constants)
+  {
+    this->staticJoints[constant.id] = false;
+  }
+  for (bool isStatic : this->staticJoints)
+  {
+    report.staticJoints += isStatic ? 1 : 0;
+  }
+  return report;
+}
+
+bool Clip::isStatic(size_t joint)
+{
+  return joint < this->staticJoints.size() && this->staticJoints[joint];
+}
+
+void Clip::regroup()
+{
+  for (auto &channel : this->groups)
+  {
+    for (std::vector<uint> &group : channel)
+    {
+      group.clear();
+    }
+  }
+
+  uint size = this->tracks.size();
+  for (uint i = 0; i < size; ++i)
+  {
+    TransformTrack &track = this->tracks[i];
+    if (track.getPosTrack().size() > 1)
+    {
+      this->groups[0][track.getPosTrack().interpolation].push_back(i);
+    }
+    if (track.getRotationTrack().size() > 1)
+    {
+      this->groups[1][track.getRotationTrack().interpolation].push_back(i);
+    }
+    if (track.getScalingTrack().size() > 1)
+    {
+      this->groups[2][track.getScalingTrack().interpolation].push_back(i);
+    }
+  }
+  this->grouped = true;
+}
+
 float Clip::adjustTimeToFitRange(float time)
 {
   if (this->looping)
@@ -82,15 +453,74 @@ void Clip::ReCalculateDuartion()
       endSet = true;
     }
   }
+  this->regroup();
 }
 
+BakeReport Clip::bake(float rate)
+{
+  BakeReport report = {0, 0, 0.0f, 0.0f, 0.0f};
+
+  for (TransformTrack &track : this->tracks)
+  {
+    TransformTrack original = track;
+    track.bake(rate);
+
+    report.keysBefore += original.getPosTrack().size() + original.getRotationTrack().size() + original.getScalingTrack().size();
+    report.keysAfter += track.getPosTrack().size() + track.getRotationTrack().size() + track.getScalingTrack().size();
+
+    float start = original.getStartTime();
+    float end = original.getEndTime();
+    float step = 1.0f / (rate * 8.0f);
+    for (float time = start; time <= end + step * 0.5f; time += step)
+    {
+      float t = time < end ? time : end;
+      Transform a = original.sample(Transform(), t, false);
+      Transform b = track.sample(Transform(), t, false);
+
+      // angle from the vector part of the relative rotation, acos of the
+      // dot product is too coarse for small errors
+      Quat relative = a.orientation.conjugate() * b.orientation;
+      float angle = 2.0f * asinf(min(axis(relative).mag(), 1.0f));
+
+      report.maxPositionError = max(report.maxPositionError, (a.translation - b.translation).mag());
+      report.maxRotationError = max(report.maxRotationError, angle);
+      report.maxScaleError = max(report.maxScaleError, (a.scaling - b.scaling).mag());
+    }
+  }
+  // baking made every channel linear
+  this->regroup();
+
+  return report;
+}
+
+CompressionReport Clip::compress(const CompressionSettings &settings)
+{
+  CompressionReport report = this->compressed.compress(this->tracks, settings);
+  std::vector<TransformTrack>().swap(this->tracks);
+  this->regroup();
+  return report;
+}
+
+bool Clip::isCompressed() { return !this->compressed.empty(); }
+
+void Clip::pack(float rate)
+{
+  this->packed.pack(this->tracks, this->startTime, this->endTime, rate);
+  std::vector<TransformTrack>().swap(this->tracks);
+  this->regroup();
+}
+
+bool Clip::isPacked() { return !this->packed.empty(); }
+
 TransformTrack &Clip::getTrack(size_t index)
 {
+  this->grouped = false;
   return this->tracks[index];
 }
 
 std::vector<TransformTrack> &Clip::getTracks()
 {
+  this->grouped = false;
   return this->tracks;
 }
 
@@ -103,6 +533,7 @@ uint Clip::getIdAtIndex(uint index)
 void Clip::resize(size_t newSize)
 {
   this->tracks.resize(newSize, TransformTrack());
+  this->regroup();
 }
 
 uint Clip::size() { return (uint)this->tracks.size(); }
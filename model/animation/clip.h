@@ -1,9 +1,62 @@
 #ifndef CLIP_H
 #define CLIP_H
 
+#include "../../math/transform.h"
+#include "compressedClip.h"
+#include "packedClip.h"
+
+#include <span>
 #include <vector>
 #include <string>
 
+/// @brief per instance playback state of a clip, one cursor per track.
+/// sized by Clip::sample on first use
+struct ClipCursor
+{
+  std::vector<struct TransformCursor> tracks;
+};
+
+/// @brief playback state of Clip::sample over many poses. keep one per
+/// crowd with the poses in the same order every call, it stops allocating
+/// once it has seen the crowd's size
+struct ClipBatch
+{
+  /// @brief clip time of each pose, what sample returns for a single pose
+  std::vector<float> times;
+  /// @brief pose indices by ascending clip time
+  std::vector<uint> order;
+  /// @brief one per pose
+  std::vector<ClipCursor> cursors;
+};
+
+/// @brief how far a baked clip strays from the curves it was baked from,
+/// measured at 8 points per baked interval
+struct BakeReport
+{
+  size_t keysBefore;
+  size_t keysAfter;
+  float maxPositionError;
+  /// @brief radians
+  float maxRotationError;
+  float maxScaleError;
+};
+
+/// @brief what Clip::removeStaticChannels found
+struct StaticReport
+{
+  /// @brief position, rotation and scale channels with any keys
+  size_t channelsBefore;
+  /// @brief channels that never leave the rest pose, or have a single key
+  /// which sample ignores. dropped
+  size_t restChannels;
+  /// @brief channels holding one value other than the rest pose, written
+  /// without sampling
+  size_t constantChannels;
+  size_t tracksRemoved;
+  /// @brief skeleton joints the clip leaves at rest
+  size_t staticJoints;
+};
+
 class Clip
 {
 public:
@@ -14,6 +67,16 @@ public:
   void setIdAtIndex(uint idx, uint id);
   uint size();
   float sample(class Pose &outPose, float inTime);
+  /// @brief same as above, keyframe lookups start from the cursor. tracks of
+  /// joints with a 0 in active are skipped, leaving those joints as they
+  /// were in outPose. packed and compressed clips sample every joint
+  float sample(class Pose &outPose, float inTime, ClipCursor &cursor, std::span<const uint8_t> active = {});
+  /// @brief samples the clip at inTimes[i] into outPoses[i]. poses at the
+  /// same clip time (instances sharing an offset) are sampled once, the
+  /// others copy the animated channels
+  void sample(std::span<class Pose> outPoses, std::span<const float> inTimes, ClipBatch &batch);
+  /// @brief also sorts the tracks into the groups sample walks, call it
+  /// after editing tracks, sample asserts it ran
   void ReCalculateDuartion();
 
   std::string &GetName();
@@ -26,8 +89,36 @@ public:
 
   void resize(size_t newSize);
 
+  /// @brief drops channels whose keys all hold the same value, within
+  /// tolerance. channels at the rest pose value are removed outright, the
+  /// others are kept as one value written by sample. tracks left without
+  /// keys are removed. assumes the pose handed to sample starts at
+  /// restPose (Model::sample does), so do this at load before bake, pack or
+  /// compress
+  StaticReport removeStaticChannels(class Pose &restPose, float tolerance = 1e-5f);
+  /// @brief the clip never moves joint away from the rest pose. false for
+  /// every joint until removeStaticChannels ran
+  bool isStatic(size_t joint);
+
+  /// @brief resamples every track to rate keys per second so keyframe lookup
+  /// becomes a multiply, see Track::bake
+  BakeReport bake(float rate);
+
+  /// @brief replaces the tracks with a CompressedClip that sample reads
+  /// from instead. the original tracks are released, so do this last
+  CompressionReport compress(const CompressionSettings &settings);
+  bool isCompressed();
+
+  /// @brief moves the keys of all tracks into one PackedClip block sampled
+  /// at rate keys per second. the original tracks are released
+  void pack(float rate);
+  bool isPacked();
+
+  /// @brief for editing tracks while loading, the clip can not be sampled
+  /// again until ReCalculateDuartion regrouped it. sample never regroups,
+  /// Animators on other threads read the same clip
   class TransformTrack &getTrack(size_t index);
- std::vector<class TransformTrack> &getTracks();
+  std::vector<class TransformTrack> &getTracks();
 
 private:
   std::string name;
@@ -35,8 +126,32 @@ private:
   float endTime;
   bool looping;
   std::vector<class TransformTrack> tracks;
+  CompressedClip compressed;
+  PackedClip packed;
+
+  // joints with constant channels, channels is a PackedChannel mask
+  struct ConstantJoint
+  {
+    size_t id;
+    uint8_t channels;
+    Transform value;
+  };
+  std::vector<ConstantJoint> constants;
+  std::vector<bool> staticJoints;
+
+  // track indices by channel (position, rotation, scale) and interpolation
+  // mode, channels with less than two keys are left out. sample runs one
+  // loop per group with the mode fixed at compile time
+  std::vector<uint> groups[3][3];
+  // false from getTrack/getTracks until the next regroup
+  bool grouped;
 
   float adjustTimeToFitRange(float time);
+  void regroup();
+  void applyConstants(class Pose &outPose);
+  template <Interpolation I, bool Masked = false>
+  void sampleGroups(std::span<class Transform> locals, float time, ClipCursor &cursor, std::span<const uint8_t> active = {});
+  void copyGroups(std::span<class Transform> from, std::span<class Transform> to);
 };
 
 #endif
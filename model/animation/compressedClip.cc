@@ -0,0 +1,423 @@
+#include "compressedClip.h"
+#include "clip.h"
+#include "pose.h"
+
+#include <algorithm>
+
+#define TIME_STEPS 65535.0f
+#define VECTOR_STEPS 65535.0f
+// longest run of keys one segment of reduce may span. each extension
+// re-checks the whole segment, the cap keeps that linear in the key count
+#define MAX_SEGMENT_KEYS 64
+
+namespace CompressionHelpers
+{
+  inline uint16_t quantize(float value, float min, float extent, float steps)
+  {
+    if (extent <= 0.0f)
+    {
+      return 0;
+    }
+    return (uint16_t)(clamp((value - min) / extent, 0.0f, 1.0f) * steps + 0.5f);
+  }
+  inline float dequantize(uint16_t value, float min, float extent, float steps)
+  {
+    return min + extent * (value / steps);
+  }
+
+  /// @brief angle of the rotation between two unit quaternions, from the
+  /// vector part of the relative rotation which stays precise near 0
+  inline float angle(const Quat &a, const Quat &b)
+  {
+    return 2.0f * asinf(min(axis(a.conjugate() * b).mag(), 1.0f));
+  }
+
+  /// @brief indices of the keys to keep so that linear interpolation between
+  /// kept keys reproduces every dropped one within tolerance. greedy, each
+  /// segment is grown as long as error(from, to, k) allows and it spans at
+  /// most MAX_SEGMENT_KEYS keys
+  template <typename Error>
+  std::vector<size_t> reduce(size_t count, const Error &error)
+  {
+    std::vector<size_t> kept = {0};
+    size_t from = 0;
+    while (from < count - 1)
+    {
+      size_t to = from + 1;
+      while (to + 1 < count && to + 1 - from <= MAX_SEGMENT_KEYS)
+      {
+        // the newest key first, it is the one most likely to fail
+        bool fits = true;
+        for (size_t k = to; k > from && fits; k--)
+        {
+          fits = error(from, to + 1, k);
+        }
+        if (!fits)
+        {
+          break;
+        }
+        to++;
+      }
+      kept.push_back(to);
+      from = to;
+    }
+    return kept;
+  }
+
+  /// @brief key at or before local in keys, stepping forward from the cursor
+  /// like Track::frameIndex before falling back to a binary search
+  template <typename Key>
+  size_t findKey(const Key *keys, size_t count, float local, TrackCursor &cursor)
+  {
+    size_t key = cursor.key;
+    if (key < count && keys[key] <= local)
+    {
+      if (key + 1 < count && keys[key + 1] <= local)
+      {
+        key++;
+      }
+      if (key + 1 < count && keys[key + 1] <= local)
+      {
+        key = count;
+      }
+    }
+    else
+    {
+      key = count;
+    }
+
+    if (key == count)
+    {
+      const Key *next = std::upper_bound(keys, keys + count, local, [](float t, Key k)
+                                         { return t < k; });
+      key = next == keys ? 0 : (next - keys) - 1;
+    }
+
+    cursor.key = key;
+    return key;
+  }
+}; // namespace CompressionHelpers
+
+bool CompressedClip::empty() { return this->tracks.empty(); }
+
+size_t CompressedClip::byteSize()
+{
+  return this->tracks.size() * sizeof(CompressedTrack) +
+         this->times.size() * sizeof(uint16_t) +
+         this->floatTimes.size() * sizeof(float) +
+         this->rotations.size() * sizeof(Quat48) +
+         this->vectors.size() * sizeof(uint16_t);
+}
+
+CompressionReport CompressedClip::compress(std::vector<TransformTrack> &source, const CompressionSettings &settings)
+{
+  CompressionReport report = {0, 0, 0, 0, 0, 0};
+
+  this->tracks.clear();
+  this->times.clear();
+  this->floatTimes.clear();
+  this->rotations.clear();
+  this->vectors.clear();
+
+  for (TransformTrack &track : source)
+  {
+    size_t id = track.getId();
+    float scale = id < settings.jointScale.size() ? settings.jointScale[id] : 1.0f;
+
+    CompressedTrack compressed;
+    compressed.id = id;
+    this->compressVectors(track.getPosTrack(), settings.positionTolerance * scale, settings.cubicBakeRate, compressed.position, report);
+    this->compressRotations(track.getRotationTrack(), settings.rotationTolerance * scale, settings.cubicBakeRate, compressed.rotation, report);
+    this->compressVectors(track.getScalingTrack(), settings.scaleTolerance * scale, settings.cubicBakeRate, compressed.scaling, report);
+    this->tracks.push_back(compressed);
+
+    report.keysBefore += track.getPosTrack().size() + track.getRotationTrack().size() + track.getScalingTrack().size();
+    report.bytesBefore += sizeof(TransformTrack) +
+                          track.getPosTrack().size() * sizeof(Frame<3>) +
+                          track.getRotationTrack().size() * sizeof(Frame<4>) +
+                          track.getScalingTrack().size() * sizeof(Frame<3>);
+  }
+
+  report.keysAfter = this->times.size() + this->floatTimes.size();
+  report.bytesAfter = this->byteSize();
+  return report;
+}
+
+/// @brief appends the kept key times of a channel as 16 bit fractions of its
+/// duration, or as floats when two distinct times would round to one step
+void CompressedClip::storeTimes(const std::vector<float> &keyTimes, CompressedChannel &out, size_t &floatChannels)
+{
+  std::vector<uint16_t> quantized(keyTimes.size());
+  out.floatTimes = false;
+  for (size_t k = 0; k < keyTimes.size(); k++)
+  {
+    quantized[k] = CompressionHelpers::quantize(keyTimes[k], out.start, out.duration, TIME_STEPS);
+    out.floatTimes = out.floatTimes || (k > 0 && quantized[k] == quantized[k - 1] && keyTimes[k] > keyTimes[k - 1]);
+  }
+
+  out.count = keyTimes.size();
+  if (out.floatTimes)
+  {
+    out.first = this->floatTimes.size();
+    this->floatTimes.insert(this->floatTimes.end(), keyTimes.begin(), keyTimes.end());
+    floatChannels++;
+    return;
+  }
+  out.first = this->times.size();
+  this->times.insert(this->times.end(), quantized.begin(), quantized.end());
+}
+
+void CompressedClip::compressVectors(VectorTrack track, float tolerance, float bakeRate, CompressedChannel &out, CompressionReport &report)
+{
+  out = CompressedChannel();
+  out.kind = ChannelAbsent;
+
+  // Track::sample leaves single key tracks to the reference pose as well
+  if (track.size() < 2)
+  {
+    return;
+  }
+  if (track.interpolation == Cubic)
+  {
+    track.bake(bakeRate);
+  }
+
+  size_t count = track.size();
+  std::vector<Vector3f> values(count);
+  Vector3f low = Vector3f(track.frames[0].m_value[0], track.frames[0].m_value[1], track.frames[0].m_value[2]);
+  Vector3f high = low;
+  bool constant = true;
+  for (size_t k = 0; k < count; k++)
+  {
+    values[k] = Vector3f(track.frames[k].m_value[0], track.frames[k].m_value[1], track.frames[k].m_value[2]);
+    low = Vector3f(min(low.x, values[k].x), min(low.y, values[k].y), min(low.z, values[k].z));
+    high = Vector3f(max(high.x, values[k].x), max(high.y, values[k].y), max(high.z, values[k].z));
+    constant = constant && (values[k] - values[0]).mag() <= tolerance;
+  }
+
+  out.step = track.interpolation == Constant;
+  out.start = track.getStartTime();
+  out.duration = track.getEndTime() - out.start;
+
+  if (constant || out.duration <= 0.0f)
+  {
+    out.kind = ChannelConstant;
+    out.constant = Quat(values[0].x, values[0].y, values[0].z, 0.0f);
+    report.constantChannels++;
+    return;
+  }
+
+  out.kind = ChannelAnimated;
+  out.min = low;
+  out.extent = high - low;
+
+  // error is measured on the quantized values, so the tolerance covers the
+  // key reduction and the quantization together
+  std::vector<uint16_t> quantized(count * 3);
+  std::vector<Vector3f> decoded(count);
+  for (size_t k = 0; k < count; k++)
+  {
+    float v[3] = {values[k].x, values[k].y, values[k].z};
+    float m[3] = {low.x, low.y, low.z};
+    float e[3] = {out.extent.x, out.extent.y, out.extent.z};
+    float d[3] = {};
+    for (int c = 0; c < 3; c++)
+    {
+      quantized[k * 3 + c] = CompressionHelpers::quantize(v[c], m[c], e[c], VECTOR_STEPS);
+      d[c] = CompressionHelpers::dequantize(quantized[k * 3 + c], m[c], e[c], VECTOR_STEPS);
+    }
+    decoded[k] = Vector3f(d[0], d[1], d[2]);
+  }
+
+  std::vector<Frame<3>> &frames = track.frames;
+  bool step = out.step;
+  std::vector<size_t> kept = CompressionHelpers::reduce(count, [&](size_t from, size_t to, size_t k)
+                                                        {
+    if (step)
+    {
+      return (decoded[from] - values[k]).mag() <= tolerance;
+    }
+    float t = (frames[k].time - frames[from].time) / (frames[to].time - frames[from].time);
+    return (lerp(decoded[from], decoded[to], t) - values[k]).mag() <= tolerance; });
+
+  std::vector<float> keyTimes;
+  out.values = this->vectors.size() / 3;
+  for (size_t k : kept)
+  {
+    keyTimes.push_back(frames[k].time);
+    this->vectors.insert(this->vectors.end(), quantized.begin() + k * 3, quantized.begin() + k * 3 + 3);
+  }
+  this->storeTimes(keyTimes, out, report.floatTimeChannels);
+}
+
+void CompressedClip::compressRotations(QuatTrack track, float tolerance, float bakeRate, CompressedChannel &out, CompressionReport &report)
+{
+  out = CompressedChannel();
+  out.kind = ChannelAbsent;
+
+  if (track.size() < 2)
+  {
+    return;
+  }
+  if (track.interpolation == Cubic)
+  {
+    track.bake(bakeRate);
+  }
+
+  size_t count = track.size();
+  std::vector<Quat> values(count);
+  bool constant = true;
+  for (size_t k = 0; k < count; k++)
+  {
+    values[k] = track.cast(track.frames[k].m_value);
+    constant = constant && CompressionHelpers::angle(values[k], values[0]) <= tolerance;
+  }
+
+  out.step = track.interpolation == Constant;
+  out.start = track.getStartTime();
+  out.duration = track.getEndTime() - out.start;
+
+  if (constant || out.duration <= 0.0f)
+  {
+    out.kind = ChannelConstant;
+    out.constant = values[0];
+    report.constantChannels++;
+    return;
+  }
+
+  out.kind = ChannelAnimated;
+
+  std::vector<Quat48> quantized(count);
+  std::vector<Quat> decoded(count);
+  for (size_t k = 0; k < count; k++)
+  {
+    quantized[k] = Quat48(values[k]);
+    decoded[k] = quantized[k].unpack();
+  }
+
+  std::vector<Frame<4>> &frames = track.frames;
+  bool step = out.step;
+  std::vector<size_t> kept = CompressionHelpers::reduce(count, [&](size_t from, size_t to, size_t k)
+                                                        {
+    if (step)
+    {
+      return CompressionHelpers::angle(decoded[from], values[k]) <= tolerance;
+    }
+    float t = (frames[k].time - frames[from].time) / (frames[to].time - frames[from].time);
+    return CompressionHelpers::angle(nlerp(decoded[from], decoded[to], t), values[k]) <= tolerance; });
+
+  std::vector<float> keyTimes;
+  out.values = this->rotations.size();
+  for (size_t k : kept)
+  {
+    keyTimes.push_back(frames[k].time);
+    this->rotations.push_back(quantized[k]);
+  }
+  this->storeTimes(keyTimes, out, report.floatTimeChannels);
+}
+
+// sampling
+//________________________________________________________________________
+//________________________________________________________________________
+
+/// @brief the key at or before time and in t how far time is towards the
+/// next key
+size_t CompressedClip::findKey(const CompressedChannel &channel, float time, TrackCursor &cursor, float &t)
+{
+  t = 0.0f;
+  if (channel.floatTimes)
+  {
+    const float *keys = this->floatTimes.data() + channel.first;
+    float local = clamp(time, channel.start, channel.start + channel.duration);
+    size_t key = CompressionHelpers::findKey(keys, channel.count, local, cursor);
+    if (key + 1 < channel.count)
+    {
+      t = (local - keys[key]) / (keys[key + 1] - keys[key]);
+    }
+    return key;
+  }
+
+  const uint16_t *keys = this->times.data() + channel.first;
+  float local = clamp((time - channel.start) / channel.duration, 0.0f, 1.0f) * TIME_STEPS;
+  size_t key = CompressionHelpers::findKey(keys, channel.count, local, cursor);
+  if (key + 1 < channel.count)
+  {
+    t = (local - keys[key]) / (float)(keys[key + 1] - keys[key]);
+  }
+  return key;
+}
+
+Vector3f CompressedClip::sampleVector(const CompressedChannel &channel, float time, TrackCursor &cursor)
+{
+  if (channel.kind == ChannelConstant)
+  {
+    return Vector3f(channel.constant.x, channel.constant.y, channel.constant.z);
+  }
+
+  float t;
+  size_t key = this->findKey(channel, time, cursor, t);
+
+  auto decode = [&](size_t k)
+  {
+    const uint16_t *v = this->vectors.data() + (channel.values + k) * 3;
+    return Vector3f(
+        CompressionHelpers::dequantize(v[0], channel.min.x, channel.extent.x, VECTOR_STEPS),
+        CompressionHelpers::dequantize(v[1], channel.min.y, channel.extent.y, VECTOR_STEPS),
+        CompressionHelpers::dequantize(v[2], channel.min.z, channel.extent.z, VECTOR_STEPS));
+  };
+
+  if (channel.step || key + 1 >= channel.count)
+  {
+    return decode(key);
+  }
+  return lerp(decode(key), decode(key + 1), t);
+}
+
+Quat CompressedClip::sampleRotation(const CompressedChannel &channel, float time, TrackCursor &cursor)
+{
+  if (channel.kind == ChannelConstant)
+  {
+    return channel.constant;
+  }
+
+  float t;
+  size_t key = this->findKey(channel, time, cursor, t);
+  const Quat48 *values = this->rotations.data() + channel.values;
+
+  if (channel.step || key + 1 >= channel.count)
+  {
+    return values[key].unpack();
+  }
+  return nlerp(values[key].unpack(), values[key + 1].unpack(), t);
+}
+
+void CompressedClip::sample(Pose &outPose, float time, ClipCursor &cursor)
+{
+  size_t size = this->tracks.size();
+  if (cursor.tracks.size() != size)
+  {
+    cursor.tracks.resize(size);
+  }
+
+  for (size_t i = 0; i < size; i++)
+  {
+    const CompressedTrack &track = this->tracks[i];
+    TransformCursor &trackCursor = cursor.tracks[i];
+    Transform local = outPose.getLocalTransform(track.id);
+
+    if (track.position.kind != ChannelAbsent)
+    {
+      local.translation = this->sampleVector(track.position, time, trackCursor.position);
+    }
+    if (track.rotation.kind != ChannelAbsent)
+    {
+      local.orientation = this->sampleRotation(track.rotation, time, trackCursor.rotation);
+    }
+    if (track.scaling.kind != ChannelAbsent)
+    {
+      local.scaling = this->sampleVector(track.scaling, time, trackCursor.scaling);
+    }
+
+    outPose.setLocalTransform(track.id, local);
+  }
+}
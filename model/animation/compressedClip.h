@@ -0,0 +1,121 @@
+#ifndef COMPRESSED_CLIP_H
+#define COMPRESSED_CLIP_H
+
+#include "../../math/packed.h"
+#include "../../math/vec3.h"
+#include "transformTrack.h"
+
+#include <stdint.h>
+#include <vector>
+
+/// @brief how far a compressed clip may stray from the original curves at
+/// their keys
+struct CompressionSettings
+{
+  CompressionSettings()
+      : positionTolerance(0.001f),
+        rotationTolerance(0.001f),
+        scaleTolerance(0.001f),
+        cubicBakeRate(60.0f) {}
+
+  float positionTolerance;
+  /// @brief radians, below ~1.5e-4 the Quat48 quantization dominates
+  float rotationTolerance;
+  float scaleTolerance;
+  /// @brief cubic curves are baked to linear keys at this rate first, key
+  /// reduction only understands linear curves
+  float cubicBakeRate;
+  /// @brief multiplies the tolerances of the joint with that id, e.g. below 1
+  /// for fingers and faces. joints past the end use 1
+  std::vector<float> jointScale;
+};
+
+struct CompressionReport
+{
+  size_t keysBefore;
+  size_t keysAfter;
+  size_t bytesBefore;
+  size_t bytesAfter;
+  /// @brief animated channels collapsed to a single value
+  size_t constantChannels;
+  /// @brief channels with keys closer than a 16 bit step of their duration,
+  /// stored with float times
+  size_t floatTimeChannels;
+};
+
+enum ChannelKind
+{
+  ChannelAbsent,
+  ChannelConstant,
+  ChannelAnimated,
+};
+
+/// @brief the position, rotation or scale curve of one joint. keys live in
+/// the clip wide arrays of CompressedClip starting at first
+struct CompressedChannel
+{
+  ChannelKind kind;
+  /// @brief constant interpolation, the value jumps at every key
+  bool step;
+  /// @brief two keys would share a 16 bit time, the key times are floats
+  /// in CompressedClip::floatTimes instead
+  bool floatTimes;
+  /// @brief index of the first key time and the number of keys
+  uint32_t first;
+  uint32_t count;
+  /// @brief index of the first key value in rotations, or in vectors
+  /// counting 3 components as one
+  uint32_t values;
+  /// @brief key times are stored as 16 bit fractions of this range
+  float start;
+  float duration;
+  /// @brief positions and scales are stored as 16 bit fractions of
+  /// [min, min + extent] per component
+  Vector3f min;
+  Vector3f extent;
+  /// @brief full precision value of constant channels
+  Quat constant;
+};
+
+struct CompressedTrack
+{
+  size_t id;
+  CompressedChannel position;
+  CompressedChannel rotation;
+  CompressedChannel scaling;
+};
+
+/// @brief a clip with redundant keys removed, constant curves collapsed and
+/// the remaining keys quantized: 2 byte times, Quat48 rotations and 3x16 bit
+/// vectors. channels whose keys do not fit 2 byte times keep float times.
+/// linear curves only, rotations are nlerped
+class CompressedClip
+{
+public:
+  CompressedClip() {}
+  ~CompressedClip() {}
+
+  bool empty();
+  size_t byteSize();
+
+  CompressionReport compress(std::vector<TransformTrack> &tracks, const CompressionSettings &settings);
+  void sample(class Pose &outPose, float time, struct ClipCursor &cursor);
+
+private:
+  std::vector<CompressedTrack> tracks;
+  std::vector<uint16_t> times;
+  std::vector<float> floatTimes;
+  std::vector<Quat48> rotations;
+  std::vector<uint16_t> vectors;
+
+  void compressVectors(VectorTrack track, float tolerance, float bakeRate, CompressedChannel &out, CompressionReport &report);
+  void compressRotations(QuatTrack track, float tolerance, float bakeRate, CompressedChannel &out, CompressionReport &report);
+
+  void storeTimes(const std::vector<float> &keyTimes, CompressedChannel &out, size_t &floatChannels);
+
+  size_t findKey(const CompressedChannel &channel, float time, TrackCursor &cursor, float &t);
+  Vector3f sampleVector(const CompressedChannel &channel, float time, TrackCursor &cursor);
+  Quat sampleRotation(const CompressedChannel &channel, float time, TrackCursor &cursor);
+};
+
+#endif
@@ -0,0 +1,246 @@
+#include "packedClip.h"
+#include "pose.h"
+#include "../../math/simd.h"
+
+#include <algorithm>
+
+bool PackedClip::empty() { return this->keyCount == 0; }
+
+size_t PackedClip::byteSize()
+{
+  return this->keys.size() * sizeof(Lanes) +
+         this->ids.size() * sizeof(size_t) +
+         this->channels.size() * sizeof(uint8_t);
+}
+
+size_t PackedClip::jointCount() { return this->joints; }
+size_t PackedClip::paddedCount() { return this->padded; }
+size_t PackedClip::getId(size_t joint) { return this->ids[joint]; }
+uint8_t PackedClip::getChannels(size_t joint) { return this->channels[joint]; }
+
+const float *PackedClip::stream(size_t key, SoAStream s)
+{
+  size_t groups = this->padded / SOA_LANES;
+  return this->keys[(key * SoAStreamCount + s) * groups].v;
+}
+
+float PackedClip::keyTime(size_t key)
+{
+  // same grid as Track::bake, the last key sits at the end
+  return key + 1 < this->keyCount ? this->startTime + key / this->rate : this->endTime;
+}
+
+void PackedClip::pack(std::vector<TransformTrack> &tracks, float start, float end, float rate)
+{
+  this->joints = tracks.size();
+  this->padded = (this->joints + SOA_LANES - 1) / SOA_LANES * SOA_LANES;
+  this->startTime = start;
+  this->endTime = end;
+  this->rate = rate;
+
+  // every channel was static or constant (see Clip::removeStaticChannels),
+  // stays empty so Clip::sample only applies the constants
+  if (tracks.empty())
+  {
+    this->keyCount = 0;
+    this->keys.clear();
+    this->ids.clear();
+    this->channels.clear();
+    return;
+  }
+
+  this->keyCount = (size_t)((end - start) * rate) + 1;
+  if (start + (this->keyCount - 1) / rate < end - 0.0001f / rate)
+  {
+    this->keyCount++;
+  }
+  // sampling always blends two keys
+  this->keyCount = std::max(this->keyCount, (size_t)2);
+
+  this->ids.resize(this->joints);
+  this->channels.resize(this->joints);
+  for (size_t j = 0; j < this->joints; j++)
+  {
+    TransformTrack &track = tracks[j];
+    this->ids[j] = track.getId();
+    this->channels[j] = (track.getPosTrack().size() > 1 ? PackedPosition : 0) |
+                        (track.getRotationTrack().size() > 1 ? PackedRotation : 0) |
+                        (track.getScalingTrack().size() > 1 ? PackedScale : 0);
+  }
+
+  size_t groups = this->padded / SOA_LANES;
+  this->keys.assign(this->keyCount * SoAStreamCount * groups, Lanes());
+
+  std::vector<TransformCursor> cursors(this->joints);
+  for (size_t key = 0; key < this->keyCount; key++)
+  {
+    float time = this->keyTime(key);
+    float *s[SoAStreamCount];
+    for (int c = 0; c < SoAStreamCount; c++)
+    {
+      s[c] = this->keys[(key * SoAStreamCount + c) * groups].v;
+    }
+
+    for (size_t j = 0; j < this->padded; j++)
+    {
+      Transform value = Transform();
+      if (j < this->joints)
+      {
+        value = tracks[j].sample(Transform(), time, false, cursors[j]);
+      }
+
+      // keep neighbouring keys in one hemisphere so the sampler can blend
+      // them without checking
+      if (key > 0)
+      {
+        const float *p[4] = {this->stream(key - 1, SoARotX), this->stream(key - 1, SoARotY),
+                             this->stream(key - 1, SoARotZ), this->stream(key - 1, SoARotW)};
+        Quat previous = Quat(p[0][j], p[1][j], p[2][j], p[3][j]);
+        if (dot(previous, value.orientation) < 0.0f)
+        {
+          value.orientation = -1.0f * value.orientation;
+        }
+      }
+
+      s[SoAPosX][j] = value.translation.x;
+      s[SoAPosY][j] = value.translation.y;
+      s[SoAPosZ][j] = value.translation.z;
+      s[SoARotX][j] = value.orientation.x;
+      s[SoARotY][j] = value.orientation.y;
+      s[SoARotZ][j] = value.orientation.z;
+      s[SoARotW][j] = value.orientation.s;
+      s[SoAScaleX][j] = value.scaling.x;
+      s[SoAScaleY][j] = value.scaling.y;
+      s[SoAScaleZ][j] = value.scaling.z;
+    }
+  }
+}
+
+void PackedClip::keysAt(float time, size_t &key, float &t)
+{
+  float offset = (time - this->startTime) * this->rate;
+  key = offset <= 0.0f ? 0 : std::min((size_t)offset, this->keyCount - 2);
+
+  float from = this->keyTime(key);
+  float to = this->keyTime(key + 1);
+  t = to > from ? clamp((time - from) / (to - from), 0.0f, 1.0f) : 0.0f;
+}
+
+// sampling
+//________________________________________________________________________
+//________________________________________________________________________
+
+// one kernel written against gcc vector types like the ones in
+// transformSoA.cc, 4 lanes everywhere and 8 lanes compiled for avx2
+
+typedef float float4v __attribute__((vector_size(16)));
+typedef int int4v __attribute__((vector_size(16)));
+typedef float float8v __attribute__((vector_size(32)));
+typedef int int8v __attribute__((vector_size(32)));
+
+struct PackedKeys
+{
+  const float *a[SoAStreamCount];
+  const float *b[SoAStreamCount];
+  float t;
+  size_t joints;
+  size_t padded;
+  const size_t *ids;
+  const uint8_t *channels;
+};
+
+template <typename V, typename I>
+[[gnu::always_inline]] static inline void sampleLanes(const PackedKeys &keys, Transform *out)
+{
+  const size_t width = sizeof(V) / sizeof(float);
+  const SoAStream linear[] = {SoAPosX, SoAPosY, SoAPosZ, SoAScaleX, SoAScaleY, SoAScaleZ};
+
+  alignas(32) float lanes[SoAStreamCount][width];
+  V t = V{} + keys.t;
+
+  for (size_t i = 0; i < keys.padded; i += width)
+  {
+    for (SoAStream s : linear)
+    {
+      V a = *(const V *)(keys.a[s] + i);
+      V b = *(const V *)(keys.b[s] + i);
+      *(V *)lanes[s] = a + (b - a) * t;
+    }
+
+    // nlerp, pack() keeps the two keys in one hemisphere
+    V rot[4];
+    for (int c = 0; c < 4; c++)
+    {
+      V a = *(const V *)(keys.a[SoARotX + c] + i);
+      V b = *(const V *)(keys.b[SoARotX + c] + i);
+      rot[c] = a + (b - a) * t;
+    }
+    V lenSqrd = rot[0] * rot[0] + rot[1] * rot[1] + rot[2] * rot[2] + rot[3] * rot[3];
+
+    V inv = (V)(0x5f375a86 - ((I)lenSqrd >> 1));
+    V half = 0.5f * lenSqrd;
+    inv = inv * (1.5f - half * inv * inv);
+    inv = inv * (1.5f - half * inv * inv);
+    inv = inv * (1.5f - half * inv * inv);
+    for (int c = 0; c < 4; c++)
+    {
+      *(V *)lanes[SoARotX + c] = rot[c] * inv;
+    }
+
+    size_t count = std::min(width, keys.joints - std::min(keys.joints, i));
+    for (size_t l = 0; l < count; l++)
+    {
+      uint8_t animated = keys.channels[i + l];
+      Transform &local = out[keys.ids[i + l]];
+      if (animated & PackedPosition)
+      {
+        local.translation = Vector3f(lanes[SoAPosX][l], lanes[SoAPosY][l], lanes[SoAPosZ][l]);
+      }
+      if (animated & PackedRotation)
+      {
+        local.orientation = Quat(lanes[SoARotX][l], lanes[SoARotY][l], lanes[SoARotZ][l], lanes[SoARotW][l]);
+      }
+      if (animated & PackedScale)
+      {
+        local.scaling = Vector3f(lanes[SoAScaleX][l], lanes[SoAScaleY][l], lanes[SoAScaleZ][l]);
+      }
+    }
+  }
+}
+
+static void sample4(const PackedKeys &keys, Transform *out) { sampleLanes<float4v, int4v>(keys, out); }
+
+#ifdef MATH_SIMD_X86
+__attribute__((target("avx2,fma"))) static void sample8(const PackedKeys &keys, Transform *out)
+{
+  sampleLanes<float8v, int8v>(keys, out);
+}
+#endif
+
+void PackedClip::sample(Pose &outPose, float time)
+{
+  PackedKeys keys;
+  size_t key = 0;
+  this->keysAt(time, key, keys.t);
+
+  // the two keys are adjacent, this walks one contiguous range
+  for (int c = 0; c < SoAStreamCount; c++)
+  {
+    keys.a[c] = this->stream(key, (SoAStream)c);
+    keys.b[c] = this->stream(key + 1, (SoAStream)c);
+  }
+  keys.joints = this->joints;
+  keys.padded = this->padded;
+  keys.ids = this->ids.data();
+  keys.channels = this->channels.data();
+
+  Transform *out = outPose.getLocalTransforms().data();
+#ifdef MATH_SIMD_X86
+  if (simdLevel() >= SimdAVX2)
+  {
+    sample8(keys, out);
+    return;
+  }
+#endif
+  sample4(keys, out);
+}
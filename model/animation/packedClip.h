@@ -0,0 +1,74 @@
+#ifndef PACKED_CLIP_H
+#define PACKED_CLIP_H
+
+#include "../../math/transformSoA.h"
+#include "transformTrack.h"
+
+#include <stdint.h>
+#include <vector>
+
+/// @brief which channels of a joint the clip animates, the others keep the
+/// pose's value like Track::sample does for empty tracks
+enum PackedChannel
+{
+  PackedPosition = 1,
+  PackedRotation = 2,
+  PackedScale = 4,
+};
+
+/// @brief a clip resampled at a fixed rate with the keys of all joints in one
+/// 32 byte aligned block. the block is ordered by key, each key holds the
+/// SoAStream streams of every joint (structure of arrays, padded to
+/// SOA_LANES joints), so sampling reads two neighbouring keys front to back
+/// and the same component of 4 or 8 joints is one aligned load.
+/// every channel is linear, rotations are nlerped and stored so consecutive
+/// keys lie in the same hemisphere
+class PackedClip
+{
+public:
+  PackedClip() : joints(0), padded(0), keyCount(0), startTime(0.0f), endTime(0.0f), rate(0.0f) {}
+  ~PackedClip() {}
+
+  bool empty();
+  size_t byteSize();
+
+  /// @brief resamples tracks at rate keys per second over [start, end],
+  /// plus one last key at end when it is off the grid. cubic and step
+  /// channels become linear, see Track::bake. tracks shorter than the clip
+  /// hold their last value. no tracks leave the clip empty
+  void pack(std::vector<TransformTrack> &tracks, float start, float end, float rate);
+  /// @brief evaluates 4 or 8 joints per step with sse or avx2 and writes
+  /// the animated channels straight into the pose's local transforms
+  void sample(class Pose &outPose, float time);
+
+  size_t jointCount();
+  /// @brief joints per key rounded up to SOA_LANES, the length of a stream
+  size_t paddedCount();
+  size_t getId(size_t joint);
+  uint8_t getChannels(size_t joint);
+
+  /// @brief the keys before and after time and the blend factor between them
+  void keysAt(float time, size_t &key, float &t);
+  /// @brief stream s of key, paddedCount floats
+  const float *stream(size_t key, SoAStream s);
+
+private:
+  struct alignas(32) Lanes
+  {
+    float v[SOA_LANES];
+  };
+
+  std::vector<Lanes> keys;
+  std::vector<size_t> ids;
+  std::vector<uint8_t> channels;
+  size_t joints;
+  size_t padded;
+  size_t keyCount;
+  float startTime;
+  float endTime;
+  float rate;
+
+  float keyTime(size_t key);
+};
+
+#endif
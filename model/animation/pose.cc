@@ -1,11 +1,12 @@
 #include "pose.h"
+#include "../../math/batch.h"
 #include "../../math/mat4.h"
 #include "../../math/transform.h"
 #include <cstring>
 
-Pose::Pose(size_t nJoints) { this->resize(nJoints); }
+Pose::Pose(size_t nJoints) : orderDirty(false) { this->resize(nJoints); }
 
-Pose::Pose(const Pose &p) { *this = p; }
+Pose::Pose(const Pose &p) : orderDirty(false) { *this = p; }
 
 Pose &Pose::operator=(const Pose &p)
 {
@@ -35,6 +36,9 @@ Pose &Pose::operator=(const Pose &p)
            sizeof(Transform) * this->joints.size());
   }
 
+  this->order = p.order;
+  this->orderDirty = p.orderDirty;
+
   return *this;
 }
 
@@ -42,6 +46,7 @@ void Pose::resize(size_t newSize)
 {
   this->joints.resize(newSize, Transform());
   this->parents.resize(newSize, -1);
+  this->orderDirty = true;
 }
 
 unsigned int Pose::size() { return (uint)this->joints.size(); }
@@ -51,6 +56,7 @@ void Pose::setLocalTransform(size_t index, const Transform &transform)
 {
   this->joints[index] = transform;
 }
+std::span<Transform> Pose::getLocalTransforms() { return this->joints; }
 
 Transform Pose::getGlobalTranform(size_t index)
 {
@@ -67,24 +73,98 @@ Transform Pose::getGlobalTranform(size_t index)
   return result;
 }
 
-void Pose::getMatrixPalette(std::vector<Mat4x4> &out)
+void Pose::getGlobalTransforms(std::vector<Transform> &out)
 {
   unsigned int size = this->size();
   if (out.size() != size)
   {
     out.resize(size);
   }
+  this->getGlobalTransforms(std::span<Transform>(out));
+}
+
+void Pose::getGlobalTransforms(std::span<Transform> out)
+{
+  if (this->orderDirty)
+  {
+    this->updateJointOrder();
+  }
+
+  for (unsigned int i : this->order)
+  {
+    int p = this->parents[i];
+    out[i] = p == -1 ? this->joints[i] : combine(out[p], this->joints[i]);
+  }
+}
+
+void Pose::updateJointOrder()
+{
+  unsigned int size = this->size();
+  this->order.clear();
+  this->order.reserve(size);
+
+  // children of every joint as one flat list, first[j] to first[j + 1]
+  std::vector<unsigned int> first(size + 1, 0);
+  for (unsigned int i = 0; i < size; ++i)
+  {
+    if (this->parents[i] >= 0 && this->parents[i] < (int)size)
+    {
+      first[this->parents[i] + 1]++;
+    }
+  }
+  for (unsigned int i = 0; i < size; ++i)
+  {
+    first[i + 1] += first[i];
+  }
+  std::vector<unsigned int> children(first[size]);
+  std::vector<unsigned int> fill(first.begin(), first.end() - 1);
   for (unsigned int i = 0; i < size; ++i)
   {
-    Transform t = this->getGlobalTranform(i);
-    out[i] = t.get();
+    if (this->parents[i] >= 0 && this->parents[i] < (int)size)
+    {
+      children[fill[this->parents[i]]++] = i;
+    }
+  }
+
+  // breadth first from the roots, order doubles as the queue
+  for (unsigned int i = 0; i < size; ++i)
+  {
+    if (this->parents[i] < 0 || this->parents[i] >= (int)size)
+    {
+      this->order.push_back(i);
+    }
+  }
+  for (size_t next = 0; next < this->order.size(); ++next)
+  {
+    unsigned int joint = this->order[next];
+    for (unsigned int c = first[joint]; c < first[joint + 1]; ++c)
+    {
+      this->order.push_back(children[c]);
+    }
+  }
+
+  // joints on a parent cycle are never reached and getGlobalTransforms
+  // leaves them untouched, gltf does not allow cycles in the node graph
+  this->orderDirty = false;
+}
+
+void Pose::getMatrixPalette(std::vector<Mat4x4> &out)
+{
+  unsigned int size = this->size();
+  if (out.size() != size)
+  {
+    out.resize(size);
   }
+  std::vector<Transform> globals;
+  this->getGlobalTransforms(globals);
+  getBatch(globals, out);
 }
 
 int Pose::getParent(size_t index) { return this->parents[index]; }
 void Pose::setParent(size_t index, int parent)
 {
   this->parents[index] = parent;
+  this->orderDirty = true;
 }
 
 bool Pose::operator==(const Pose &other)
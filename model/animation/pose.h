@@ -1,13 +1,14 @@
 #ifndef POSE_H
 #define POSE_H
 
+#include <span>
 #include <vector>
 #include "../../math/transform.h"
 
 class Pose
 {
 public:
-  Pose() {};
+  Pose() : orderDirty(false) {};
   Pose(size_t nJoints);
   Pose(const Pose &pose);
   ~Pose() {}
@@ -24,13 +25,29 @@ public:
 
   Transform getLocalTransform(size_t index);
   void setLocalTransform(size_t index, const Transform &transform);
+  /// @brief every local transform, for samplers that write many joints
+  std::span<Transform> getLocalTransforms();
+  /// @brief world transform of a single joint, walks up to the root
   Transform getGlobalTranform(size_t index);
+  /// @brief world transforms of every joint in one sweep over the joints in
+  /// parent before child order, each combine reuses the parent's result
+  void getGlobalTransforms(std::vector<Transform> &out);
+  /// @brief same, into a caller owned span of size() transforms
+  void getGlobalTransforms(std::span<Transform> out);
+
+  /// @brief sorts the joints parents first for getGlobalTransforms. runs
+  /// lazily after setParent/resize, call it once after loading so copies of
+  /// the pose start out sorted
+  void updateJointOrder();
 
   void getMatrixPalette(std::vector<struct Mat4x4> &out);
 
 private:
   std::vector<Transform> joints;
   std::vector<int> parents;
+  // joint indices, every parent comes before its children
+  std::vector<unsigned int> order;
+  bool orderDirty;
 };
 
 #endif
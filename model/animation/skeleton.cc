@@ -1,4 +1,51 @@
 #include "skeleton.h"
 #include "pose.h"
 
-Skeleton::Skeleton() : restPose(Pose()) {}
\ No newline at end of file
+Skeleton::Skeleton() : restPose(Pose()), boundRadius(0.0f) {}
+
+void Skeleton::computeBounds()
+{
+  size_t size = this->restPose.size();
+  std::vector<Transform> world(size);
+  this->restPose.getGlobalTransforms(world);
+
+  this->boundCenter = Vector3f();
+  this->boundRadius = 0.0f;
+  this->jointExtents.assign(size, 0.0f);
+  if (size == 0)
+  {
+    return;
+  }
+
+  for (Transform &joint : world)
+  {
+    this->boundCenter += joint.translation * (1.0f / (float)size);
+  }
+  for (Transform &joint : world)
+  {
+    this->boundRadius = max(this->boundRadius, (joint.translation - this->boundCenter).mag());
+  }
+
+  // every joint widens the extent of each of its ancestors
+  for (size_t i = 0; i < size; i++)
+  {
+    int parent = this->restPose.getParent(i);
+    if (parent != -1)
+    {
+      float bone = (world[i].translation - world[parent].translation).mag();
+      this->jointExtents[i] = max(this->jointExtents[i], bone);
+    }
+    for (size_t depth = 0; parent != -1 && depth < size; depth++)
+    {
+      float reach = (world[i].translation - world[parent].translation).mag();
+      this->jointExtents[parent] = max(this->jointExtents[parent], reach);
+      parent = this->restPose.getParent((size_t)parent);
+    }
+  }
+
+  float diameter = 2.0f * this->boundRadius;
+  for (float &extent : this->jointExtents)
+  {
+    extent = diameter > 0.0f ? min(extent / diameter, 1.0f) : 1.0f;
+  }
+}
@@ -1,7 +1,8 @@
 #ifndef SKELETON_H
 #define SKELETON_H
 
-#include "../../math/mat4.h"
+#include "../../math/dualQuat.h"
+#include "../../math/mat3x4.h"
 #include "pose.h"
 #include <vector>
 #include <string>
@@ -13,8 +14,22 @@ public:
   ~Skeleton() {}
 
   Pose restPose;
-  std::vector<Mat4x4> inversePose;
+  std::vector<Mat3x4> inversePose;
+  /// @brief rigid part of inversePose, for dual quaternion skinning
+  std::vector<DualQuat> inverseDualPose;
   std::vector<std::string> jointNames;
+  /// @brief node index in the source file of every joint, joints are a
+  /// subset of the file's nodes
+  std::vector<int> jointNodes;
+
+  /// @brief sphere around the rest pose joints, filled by computeBounds
+  Vector3f boundCenter;
+  float boundRadius;
+  /// @brief per joint, how far its subtree reaches in the rest pose (the
+  /// farthest joint below it, the bone to its parent for leaves) over the
+  /// bound's diameter. small for fingers and facial bones, see AnimationLod
+  std::vector<float> jointExtents;
+  void computeBounds();
 
   // std::vector<Mat4x4> getFinalMat() const;
 };
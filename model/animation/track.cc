@@ -1,36 +1,46 @@
 #include "track.h"
+#include <algorithm>
 #include <cstring>
 
 template class Track<float, 1>;
 template class Track<Vector3f, 3>;
 template class Track<Quat, 4>;
 
+#define INSTANTIATE_SAMPLE_MODE(T, N)                                           \
+  template T Track<T, N>::sampleMode<Constant>(float, bool, TrackCursor &); \
+  template T Track<T, N>::sampleMode<Linear>(float, bool, TrackCursor &);   \
+  template T Track<T, N>::sampleMode<Cubic>(float, bool, TrackCursor &);
+
 namespace TrackHelpers
 {
-  inline float interpolate(float a, float b, float c)
+  inline float interpolate(float a, float b, float c, QuatInterp)
   {
     return (1.0 - c) * a + c * b;
   }
-  inline Vector3f interpolate(const Vector3f &a, const Vector3f &b, float c)
+  inline Vector3f interpolate(const Vector3f &a, const Vector3f &b, float c, QuatInterp)
   {
     return lerp(a, b, c);
   }
-  inline Quat interpolate(Quat &a, Quat &b, float c)
+  inline Quat interpolate(Quat &a, Quat &b, float c, QuatInterp mode)
   {
-    Quat result = mix(a, b, c);
-
-    if (dot(a, b) < 0.0)
-    {
-      result = mix(a, -1.0 * b, c);
-    }
-
-    return result.unit();
+    return ::interpolate(a, b, c, mode);
   }
 
   inline float AdjustHermiteResult(float f) { return f; }
   inline Vector3f AdjustHermiteResult(const Vector3f &v) { return v; }
   inline Quat AdjustHermiteResult(Quat &q) { return q.unit(); }
 
+  /// @brief tangents are read as they are, cast would normalize quaternion
+  /// tangents
+  template <typename T>
+  inline T load(const float *value);
+  template <>
+  inline float load<float>(const float *value) { return value[0]; }
+  template <>
+  inline Vector3f load<Vector3f>(const float *value) { return Vector3f(value[0], value[1], value[2]); }
+  template <>
+  inline Quat load<Quat>(const float *value) { return Quat(value[0], value[1], value[2], value[3]); }
+
   inline void Neighborhood(const float &a, float &b) {}
   inline void Neighborhood(const Vector3f &a, Vector3f &b) {}
   inline void Neighborhood(const Quat &a, Quat &b)
@@ -62,18 +72,43 @@ float Track<T, N>::getEndTime()
 
 template <typename T, size_t N>
 T Track<T, N>::sample(float time, bool looping)
+{
+  TrackCursor cursor;
+  return this->sample(time, looping, cursor);
+}
+
+template <typename T, size_t N>
+T Track<T, N>::sample(float time, bool looping, TrackCursor &cursor)
 {
   if (interpolation == Interpolation::Constant)
   {
-    return sampleConst(time, looping);
+    return sampleMode<Constant>(time, looping, cursor);
   }
   else if (interpolation == Interpolation::Linear)
   {
-    return sampleLinear(time, looping);
+    return sampleMode<Linear>(time, looping, cursor);
   }
   else
   {
-    return sampleCubic(time, looping);
+    return sampleMode<Cubic>(time, looping, cursor);
+  }
+}
+
+template <typename T, size_t N>
+template <Interpolation I>
+T Track<T, N>::sampleMode(float time, bool looping, TrackCursor &cursor)
+{
+  if constexpr (I == Constant)
+  {
+    return sampleConst(time, looping, cursor);
+  }
+  else if constexpr (I == Linear)
+  {
+    return sampleLinear(time, looping, cursor);
+  }
+  else
+  {
+    return sampleCubic(time, looping, cursor);
   }
 }
 
@@ -97,7 +132,16 @@ T Track<T, N>::hermite(float t, const T &p1, const T &s1, const T &_p2,
 template <typename T, size_t N>
 size_t Track<T, N>::frameIndex(float time, bool looping)
 {
-  if (this->frames.size() < 1)
+  TrackCursor cursor;
+  cursor.key = this->frames.size();
+  return this->frameIndex(time, looping, cursor);
+}
+
+template <typename T, size_t N>
+size_t Track<T, N>::frameIndex(float time, bool looping, TrackCursor &cursor)
+{
+  size_t size = this->frames.size();
+  if (size < 1)
   {
     return -1;
   }
@@ -116,25 +160,97 @@ size_t Track<T, N>::frameIndex(float time, bool looping)
   }
   else
   {
-    if (time <= this->getStartTime())
+    if (time <= this->getStartTime() || size < 2)
     {
+      cursor.key = 0;
       return 0;
     }
-    if (time >= this->frames[this->frames.size() - 2].time)
+    if (time >= this->frames[size - 2].time)
     {
-      return this->frames.size() - 2;
+      cursor.key = size - 2;
+      return size - 2;
     }
   }
 
-  for (size_t i = this->frames.size() - 1; i >= 0; --i)
+  // baked tracks, key i sits at start + i / rate except for the last one
+  if (this->sampleRate > 0.0f && size > 1)
+  {
+    float offset = (time - this->getStartTime()) * this->sampleRate;
+    size_t key = offset <= 0.0f ? 0 : std::min((size_t)offset, size - 2);
+    cursor.key = key;
+    return key;
+  }
+
+  // playing forward, time is usually still within the cursor's key or one
+  // key further along. anything else is a seek and gets searched for
+  size_t key = cursor.key;
+  if (key < size && this->frames[key].time <= time)
   {
-    if (time >= this->frames[i].time)
+    if (key + 1 < size && this->frames[key + 1].time <= time)
+    {
+      key++;
+    }
+    if (key + 1 < size && this->frames[key + 1].time <= time)
     {
-      return i;
+      key = size;
     }
   }
+  else
+  {
+    key = size;
+  }
 
-  return -1;
+  if (key == size)
+  {
+    auto next = std::upper_bound(
+        this->frames.begin(), this->frames.end(), time,
+        [](float t, const Frame<N> &frame)
+        { return t < frame.time; });
+    key = next == this->frames.begin() ? 0 : (next - this->frames.begin()) - 1;
+  }
+
+  cursor.key = key;
+  return key;
+}
+
+template <typename T, size_t N>
+void Track<T, N>::bake(float rate)
+{
+  if (this->frames.size() < 2 || rate <= 0.0f)
+  {
+    return;
+  }
+
+  float startTime = this->getStartTime();
+  float endTime = this->getEndTime();
+  size_t count = (size_t)((endTime - startTime) * rate) + 1;
+
+  std::vector<Frame<N>> baked(count);
+  TrackCursor cursor;
+  for (size_t i = 0; i < count; i++)
+  {
+    baked[i].time = startTime + i / rate;
+  }
+  // the end is rarely on the grid, keep it as a shorter last interval
+  if (baked.back().time < endTime - 0.0001f / rate)
+  {
+    baked.emplace_back();
+    baked.back().time = endTime;
+  }
+  for (Frame<N> &frame : baked)
+  {
+    T value = this->sample(frame.time, false, cursor);
+    memcpy(frame.m_value, &value, N * sizeof(float));
+    memset(frame.m_in, 0, N * sizeof(float));
+    memset(frame.m_out, 0, N * sizeof(float));
+  }
+
+  this->frames.swap(baked);
+  if (this->interpolation == Interpolation::Cubic)
+  {
+    this->interpolation = Interpolation::Linear;
+  }
+  this->sampleRate = rate;
 }
 
 template <typename T, size_t N>
@@ -196,9 +312,9 @@ Quat Track<Quat, 4>::cast(float *value)
 }
 
 template <typename T, size_t N>
-T Track<T, N>::sampleConst(float time, bool looping)
+T Track<T, N>::sampleConst(float time, bool looping, TrackCursor &cursor)
 {
-  size_t index = this->frameIndex(time, looping);
+  size_t index = this->frameIndex(time, looping, cursor);
 
   if ((int)index < 0 || (int)index >= (int)this->frames.size())
   {
@@ -209,9 +325,9 @@ T Track<T, N>::sampleConst(float time, bool looping)
 }
 
 template <typename T, size_t N>
-T Track<T, N>::sampleLinear(float time, bool looping)
+T Track<T, N>::sampleLinear(float time, bool looping, TrackCursor &cursor)
 {
-  size_t index = this->frameIndex(time, looping);
+  size_t index = this->frameIndex(time, looping, cursor);
   if ((int)index < 0 || (int)index >= (int)this->frames.size() - 1)
   {
     return T();
@@ -231,12 +347,12 @@ T Track<T, N>::sampleLinear(float time, bool looping)
   T start = cast(&this->frames[index].m_value[0]);
   T end = cast(&this->frames[nextFrame].m_value[0]);
 
-  return TrackHelpers::interpolate(start, end, t);
+  return TrackHelpers::interpolate(start, end, t, this->quatInterp);
 }
 template <typename T, size_t N>
-T Track<T, N>::sampleCubic(float time, bool looping)
+T Track<T, N>::sampleCubic(float time, bool looping, TrackCursor &cursor)
 {
-  int thisFrame = this->frameIndex(time, looping);
+  int thisFrame = this->frameIndex(time, looping, cursor);
   if (thisFrame < 0 || thisFrame >= this->frames.size() - 1)
   {
     return T();
@@ -252,15 +368,14 @@ T Track<T, N>::sampleCubic(float time, bool looping)
   }
 
   float t = (trackTime - thisTime) / frameDelta;
-  size_t fltSize = sizeof(float);
   T point1 = cast(&this->frames[thisFrame].m_value[0]);
-  T slope1; // = mFrames[thisFrame].mOut * frameDelta;
-  memcpy(&slope1, this->frames[thisFrame].m_out, N * fltSize);
-  slope1 = slope1 * frameDelta;
+  T slope1 = TrackHelpers::load<T>(this->frames[thisFrame].m_out) * frameDelta;
   T point2 = cast(&this->frames[nextFrame].m_value[0]);
-  T slope2; // = mFrames[nextFrame].mIn[0] * frameDelta;
-  memcpy(&slope2, this->frames[nextFrame].m_in, N * fltSize);
-  slope2 = slope2 * frameDelta;
+  T slope2 = TrackHelpers::load<T>(this->frames[nextFrame].m_in) * frameDelta;
 
   return hermite(t, point1, slope1, point2, slope2);
 }
+
+INSTANTIATE_SAMPLE_MODE(float, 1)
+INSTANTIATE_SAMPLE_MODE(Vector3f, 3)
+INSTANTIATE_SAMPLE_MODE(Quat, 4)
@@ -6,15 +6,30 @@
 #include "frame.h"
 #include <vector>
 
+/// @brief playback position of one track, kept between sample calls by
+/// whoever plays the track back (one per animated instance) so lookups
+/// usually just step to the next key
+struct TrackCursor
+{
+  TrackCursor() : key(0) {}
+
+  size_t key;
+};
+
 /// @brief holds the animation for a single skeleton joint
 /// @tparam N track type (1=scalar track, 3=vector track, 4=quaternion track)
 template <typename T, size_t N> class Track {
 public:
-  Track() : interpolation(Linear) {}
+  Track() : interpolation(Linear), quatInterp(QuatNlerp), sampleRate(0.0f) {}
   ~Track() {}
 
   std::vector<Frame<N>> frames;
   Interpolation interpolation;
+  /// @brief accuracy of linear rotation sampling, only used by QuatTrack
+  QuatInterp quatInterp;
+  /// @brief keys per second when the keys are evenly spaced (see bake), the
+  /// key index is then computed instead of searched. 0 for arbitrary times
+  float sampleRate;
 
   unsigned int size();
 
@@ -22,14 +37,29 @@ public:
   float getEndTime();
 
   T sample(float time, bool looping);
-  T sampleConst(float time, bool looping);
-  T sampleLinear(float time, bool looping);
-  T sampleCubic(float time, bool looping);
+  T sample(float time, bool looping, TrackCursor &cursor);
+  T sampleConst(float time, bool looping, TrackCursor &cursor);
+  T sampleLinear(float time, bool looping, TrackCursor &cursor);
+  T sampleCubic(float time, bool looping, TrackCursor &cursor);
+  /// @brief sample for an interpolation mode known at compile time, no
+  /// branch on the interpolation member. Clip calls these on tracks it
+  /// grouped by mode
+  template <Interpolation I>
+  T sampleMode(float time, bool looping, TrackCursor &cursor);
 
+  /// @brief index of the last key at or before time, binary search
   size_t frameIndex(float time, bool looping);
+  /// @brief same, starting from the cursor's key. a step forward is found
+  /// without searching, anything else (seeks, loops) falls back to the
+  /// binary search
+  size_t frameIndex(float time, bool looping, TrackCursor &cursor);
   float adjustToFitTrack(float time, bool looping);
   T hermite(float time, const T &p1, const T &s1, const T &p2, const T &s2);
 
+  /// @brief resamples the track to rate keys per second starting at its first
+  /// key, plus one last key at its end time. cubic tracks become linear ones
+  void bake(float rate);
+
   T cast(float *value);
 };
 
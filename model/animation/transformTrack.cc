@@ -72,18 +72,30 @@ float TransformTrack::getEndTime() {
   return result;
 }
 
+void TransformTrack::bake(float rate) {
+  this->position.bake(rate);
+  this->rotation.bake(rate);
+  this->scaling.bake(rate);
+}
+
 Transform TransformTrack::sample(const Transform &ref, float time,
                                  bool looping) {
+  TransformCursor cursor;
+  return this->sample(ref, time, looping, cursor);
+}
+
+Transform TransformTrack::sample(const Transform &ref, float time,
+                                 bool looping, TransformCursor &cursor) {
   Transform result = ref;
 
   if (this->position.size() > 1) {
-    result.translation = this->position.sample(time, looping);
+    result.translation = this->position.sample(time, looping, cursor.position);
   }
   if (this->rotation.size() > 1) {
-    result.orientation = this->rotation.sample(time, looping);
+    result.orientation = this->rotation.sample(time, looping, cursor.rotation);
   }
   if (this->scaling.size() > 1) {
-    result.scaling = this->scaling.sample(time, looping);
+    result.scaling = this->scaling.sample(time, looping, cursor.scaling);
   }
 
   return result;
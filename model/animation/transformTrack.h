@@ -4,6 +4,15 @@
 #include "track.h"
 
 class Transform;
+
+/// @brief cursors of the three component tracks
+struct TransformCursor
+{
+  TrackCursor position;
+  TrackCursor rotation;
+  TrackCursor scaling;
+};
+
 class TransformTrack
 {
 public:
@@ -20,7 +29,11 @@ public:
   float getEndTime();
   bool isValid();
 
+  /// @brief bakes the three component tracks, see Track::bake
+  void bake(float rate);
+
   Transform sample(const Transform &ref, float time, bool looping);
+  Transform sample(const Transform &ref, float time, bool looping, TransformCursor &cursor);
 
 private:
   VectorTrack position;
@@ -14,6 +14,51 @@
 
 namespace fs = std::filesystem;
 
+std::vector<int> getNodeParents(const tinygltf::Model &tinyModel)
+{
+  std::vector<int> parents(tinyModel.nodes.size(), -1);
+  for (int i = 0; i < tinyModel.nodes.size(); i++)
+  {
+    for (int child : tinyModel.nodes[i].children)
+    {
+      parents[child] = i;
+    }
+  }
+  return parents;
+}
+
+/// @brief joints are the nodes of the first skin plus every ancestor, whose
+/// transforms still feed the joints' world transforms. they keep the file's
+/// node order. files without a skin keep every node
+void buildJointMap(const tinygltf::Model &tinyModel, std::vector<int> &nodeToJoint, std::vector<int> &jointToNode)
+{
+  size_t nodes = tinyModel.nodes.size();
+  std::vector<bool> keep(nodes, tinyModel.skins.empty());
+
+  if (!tinyModel.skins.empty())
+  {
+    std::vector<int> parents = getNodeParents(tinyModel);
+    for (int joint : tinyModel.skins[0].joints)
+    {
+      for (int node = joint; node != -1 && !keep[node]; node = parents[node])
+      {
+        keep[node] = true;
+      }
+    }
+  }
+
+  nodeToJoint.assign(nodes, -1);
+  jointToNode.clear();
+  for (int i = 0; i < nodes; i++)
+  {
+    if (keep[i])
+    {
+      nodeToJoint[i] = (int)jointToNode.size();
+      jointToNode.push_back(i);
+    }
+  }
+}
+
 GLTFFile::GLTFFile(std::string &path)
 {
   tinygltf::TinyGLTF loader;
@@ -23,14 +68,63 @@ GLTFFile::GLTFFile(std::string &path)
   {
     throw std::runtime_error(warn + err);
   }
+
+  buildJointMap(this->tinyModel, this->nodeToJoint, this->jointToNode);
 }
 
-void GLTFFile::populateModel(Model &model)
+void GLTFFile::populateModel(Model &model, float bakeRate, const CompressionSettings *compression, bool pack)
 {
   model.meshes = this->getMeshes();
   model.clips = this->getClips();
   model.textures = this->getTextures();
   model.skeleton = this->getSkeleton();
+
+  // before anything resamples the tracks, constant channels would be baked
+  // into keys again
+  for (Clip &clip : model.clips)
+  {
+    StaticReport report = clip.removeStaticChannels(model.skeleton.restPose);
+    std::cout << "clip " << clip.GetName() << ": "
+              << report.restChannels << " rest and " << report.constantChannels << " constant channels out of "
+              << report.channelsBefore << ", " << report.tracksRemoved << " tracks removed, "
+              << report.staticJoints << " joints never sampled\n";
+  }
+
+  if (bakeRate > 0.0f)
+  {
+    for (Clip &clip : model.clips)
+    {
+      if (pack)
+      {
+        clip.pack(bakeRate);
+        std::cout << "packed clip " << clip.GetName() << " at " << bakeRate << "Hz\n";
+        continue;
+      }
+      BakeReport report = clip.bake(bakeRate);
+      std::cout << "baked clip " << clip.GetName() << " at " << bakeRate << "Hz: "
+                << report.keysBefore << " -> " << report.keysAfter << " keys, max error "
+                << report.maxPositionError << " position, "
+                << report.maxRotationError << " rad, "
+                << report.maxScaleError << " scale\n";
+    }
+  }
+
+  if (compression)
+  {
+    for (Clip &clip : model.clips)
+    {
+      if (clip.isPacked())
+      {
+        continue;
+      }
+      CompressionReport report = clip.compress(*compression);
+      std::cout << "compressed clip " << clip.GetName() << ": "
+                << report.keysBefore << " -> " << report.keysAfter << " keys, "
+                << report.bytesBefore << " -> " << report.bytesAfter << " bytes, "
+                << report.constantChannels << " constant channels, "
+                << report.floatTimeChannels << " with float times\n";
+    }
+  }
 }
 
 template <typename T>
@@ -120,19 +214,24 @@ std::vector<Mesh> GLTFFile::getMeshes()
       it = primitive.attributes.find("JOINTS_0");
       if (it != primitive.attributes.end())
       {
-        const unsigned short *joints = getData<unsigned short>(this->tinyModel, it->second);
-        int count = tinyModel.accessors[it->second].count;
+        // skin joint indices are bytes or shorts, remapped from skin order
+        // to node and from node to skeleton joint
+        const tinygltf::Accessor &accessor = tinyModel.accessors[it->second];
+        const unsigned short *shorts = getData<unsigned short>(this->tinyModel, it->second);
+        const unsigned char *bytes = getData<unsigned char>(this->tinyModel, it->second);
+        bool byteJoints = accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+        int count = accessor.count;
 
         std::vector<int> skinjoints;
         skinjoints = tinyModel.skins[0].joints;
 
         for (size_t i = 0; i < count; ++i)
         {
-
-          tmpmesh.vertices[i].joints[0] = skinjoints[joints[i * 4 + 0]];
-          tmpmesh.vertices[i].joints[1] = skinjoints[joints[i * 4 + 1]];
-          tmpmesh.vertices[i].joints[2] = skinjoints[joints[i * 4 + 2]];
-          tmpmesh.vertices[i].joints[3] = skinjoints[joints[i * 4 + 3]];
+          for (int k = 0; k < 4; k++)
+          {
+            size_t skinJoint = byteJoints ? bytes[i * 4 + k] : shorts[i * 4 + k];
+            tmpmesh.vertices[i].joints[k] = skinJoint < skinjoints.size() ? this->nodeToJoint[skinjoints[skinJoint]] : 0;
+          }
         };
       }
       else
@@ -225,29 +324,30 @@ std::vector<Texture> GLTFFile::getTextures()
   return textures;
 }
 
-std::vector<std::string> getJointNames(const tinygltf::Model &tinyModel)
+std::vector<std::string> getJointNames(const tinygltf::Model &tinyModel, const std::vector<int> &jointToNode)
 {
 
   std::vector<std::string> names;
-  names.resize(tinyModel.nodes.size());
-  for (int i = 0; i < tinyModel.nodes.size(); i++)
+  names.resize(jointToNode.size());
+  for (int i = 0; i < jointToNode.size(); i++)
   {
-    const tinygltf::Node &node = tinyModel.nodes[i];
+    const tinygltf::Node &node = tinyModel.nodes[jointToNode[i]];
     names[i] = node.name;
   }
 
   return names;
 }
 
-Pose getRestPose(const tinygltf::Model &tinyModel)
+Pose getRestPose(const tinygltf::Model &tinyModel, const std::vector<int> &nodeToJoint, const std::vector<int> &jointToNode)
 {
   Pose result;
-  result.resize(tinyModel.nodes.size());
+  result.resize(jointToNode.size());
+  std::vector<int> parents = getNodeParents(tinyModel);
 
-  for (int i = 0; i < tinyModel.nodes.size(); i++)
+  for (int i = 0; i < jointToNode.size(); i++)
   {
 
-    const tinygltf::Node &node = tinyModel.nodes[i];
+    const tinygltf::Node &node = tinyModel.nodes[jointToNode[i]];
 
     Transform finalTransform;
 
@@ -299,19 +399,19 @@ Pose getRestPose(const tinygltf::Model &tinyModel)
 
      std::cout << mat.rc[3][0] << " " << mat.rc[3][1] << " " << mat.rc[3][2] << " " << mat.rc[3][3] << "\n"; */
 
-    for (int j = 0; j < node.children.size(); j++)
-    {
-      result.setParent(node.children[j], i);
-    }
+    // every ancestor of a joint is a joint as well
+    int parent = parents[jointToNode[i]];
+    result.setParent(i, parent == -1 ? -1 : nodeToJoint[parent]);
   }
+  result.updateJointOrder();
 
   return result;
 }
 
-std::vector<Mat4x4> getIverseMatrices(const tinygltf::Model &tinyModel)
+std::vector<Mat3x4> getIverseMatrices(const tinygltf::Model &tinyModel, const std::vector<int> &nodeToJoint, size_t joints)
 {
-  std::vector<Mat4x4> inverseMats;
-  inverseMats.resize(tinyModel.nodes.size(), identity());
+  std::vector<Mat3x4> inverseMats;
+  inverseMats.resize(joints, identity3x4());
 
   const tinygltf::Skin &skin = tinyModel.skins[0];
 
@@ -324,15 +424,15 @@ std::vector<Mat4x4> getIverseMatrices(const tinygltf::Model &tinyModel)
 
   for (int j = 0; j < skin.joints.size(); j++)
   {
-    int index = skin.joints[j];
+    int index = nodeToJoint[skin.joints[j]];
     /*   inverseMats[index] = tmpMatrixData[i].transpose(); */
-    inverseMats[index] =
+    inverseMats[index] = Mat3x4(
         Mat4x4(
             data[j * 16 + 0], data[j * 16 + 1], data[j * 16 + 2], data[j * 16 + 3],
             data[j * 16 + 4], data[j * 16 + 5], data[j * 16 + 6], data[j * 16 + 7],
             data[j * 16 + 8], data[j * 16 + 9], data[j * 16 + 10], data[j * 16 + 11],
             data[j * 16 + 12], data[j * 16 + 13], data[j * 16 + 14], data[j * 16 + 15])
-            .transpose();
+            .transpose());
 
     /* std::cout << "joint index: " << index << "\n";
       std::cout << inverseMats[index].rc[0][0] << " " << inverseMats[index].rc[0][1] << " " << inverseMats[index].rc[0][2] << " " << inverseMats[index].rc[0][3] << "\n";
@@ -350,9 +450,16 @@ Skeleton GLTFFile::getSkeleton()
 {
   Skeleton result;
 
-  result.jointNames = getJointNames(this->tinyModel);
-  result.inversePose = getIverseMatrices(this->tinyModel);
-  result.restPose = getRestPose(this->tinyModel);
+  result.jointNames = getJointNames(this->tinyModel, this->jointToNode);
+  result.jointNodes = this->jointToNode;
+  result.inversePose = getIverseMatrices(this->tinyModel, this->nodeToJoint, this->jointToNode.size());
+  result.inverseDualPose.resize(result.inversePose.size());
+  for (int i = 0; i < result.inversePose.size(); i++)
+  {
+    result.inverseDualPose[i] = dualQuatFromTransform(transformFromMat(result.inversePose[i])).unit();
+  }
+  result.restPose = getRestPose(this->tinyModel, this->nodeToJoint, this->jointToNode);
+  result.computeBounds();
 
   return result;
 }
@@ -416,7 +523,7 @@ void editTrack(
   }
 }
 
-Clip getClip(const tinygltf::Model &tinyModel, const tinygltf::Animation &animation)
+Clip getClip(const tinygltf::Model &tinyModel, const tinygltf::Animation &animation, const std::vector<int> &nodeToJoint)
 {
   Clip clip;
 
@@ -425,13 +532,15 @@ Clip getClip(const tinygltf::Model &tinyModel, const tinygltf::Animation &animat
     const tinygltf::AnimationChannel &channel = animation.channels[i];
     const tinygltf::AnimationSampler &animSampler = animation.samplers[channel.sampler];
 
-    if (channel.target_node < 0)
+    // channels of nodes outside the skeleton cannot move a skinned vertex
+    if (channel.target_node < 0 || nodeToJoint[channel.target_node] < 0)
       continue;
+    int target = nodeToJoint[channel.target_node];
 
     bool exists = false;
     for (int joint = 0; joint < clip.size(); joint++)
     {
-      if (clip.getTrack(joint).getId() == channel.target_node)
+      if (clip.getTrack(joint).getId() == target)
       {
         editTrack(tinyModel, animSampler, channel, clip.getTrack(joint));
         exists = true;
@@ -442,7 +551,7 @@ Clip getClip(const tinygltf::Model &tinyModel, const tinygltf::Animation &animat
     if (!exists)
     {
       TransformTrack jointTrack;
-      jointTrack.setId(channel.target_node);
+      jointTrack.setId(target);
       editTrack(tinyModel, animSampler, channel, jointTrack);
       clip.getTracks().push_back(jointTrack);
     }
@@ -459,7 +568,7 @@ std::vector<Clip> GLTFFile::getClips()
   for (int i = 0; i < this->tinyModel.animations.size(); i++)
   {
     const tinygltf::Animation &animation = this->tinyModel.animations[i];
-    clips.push_back(getClip(this->tinyModel, animation));
+    clips.push_back(getClip(this->tinyModel, animation, this->nodeToJoint));
   }
 
   return clips;
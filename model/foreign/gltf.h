@@ -12,10 +12,20 @@ public:
   GLTFFile(std::string &path);
   ~GLTFFile() {}
 
-  void populateModel(class Model &model);
+  /// @brief fills the model from the file. with a bakeRate above 0 every
+  /// clip is resampled to that many keys per second and the bake error is
+  /// printed, or with pack moved into a PackedClip at that rate instead.
+  /// with compression set unpacked clips are then compressed and the size
+  /// reduction printed
+  void populateModel(class Model &model, float bakeRate = 0.0f, const struct CompressionSettings *compression = nullptr, bool pack = false);
 
 private:
   tinygltf::Model tinyModel;
+  // the skeleton keeps only the skin's joints and their ancestors, meshes,
+  // cameras and helper nodes elsewhere in the scene are left out. -1 for
+  // nodes that are not joints
+  std::vector<int> nodeToJoint;
+  std::vector<int> jointToNode;
 
   std::vector<struct Mesh> getMeshes();
   std::vector<class Texture> getTextures();
@@ -1,6 +1,7 @@
 #include "model.h"
+#include "../math/batch.h"
 
-Model::Model() : currAnim(-1), pose(Pose()), color(Color3f(1.0)), skeleton(Skeleton()), transform(new Transform()) {}
+Model::Model() : currAnim(-1), skinning(SkinLinear), pose(Pose()), color(Color3f(1.0)), skeleton(Skeleton()), transform(new Transform()), cursorAnim(-1), fadeAnim(-1), fadeStart(-1.0f), fadeDuration(0.0f) {}
 
 void Model::translate(Vector3f pos) { this->transform->translation = pos; }
 
@@ -13,6 +14,14 @@ void Model::orient(Quat orientation)
 
 Mat4x4 Model::get_transform() { return this->transform->get(); }
 
+Mat3x3 Model::get_normal_transform()
+{
+  Mat3x3 result;
+  Mat3x4 affine = this->transform->getAffine();
+  normalBatch(std::span<const Mat3x4>(&affine, 1), std::span<Mat3x3>(&result, 1));
+  return result;
+}
+
 void Model::render()
 {
   for (auto &mesh : meshes)
@@ -23,31 +32,150 @@ void Model::render()
 
 void Model::animate(float elapsed)
 {
-  this->pose = this->skeleton.restPose;
-  if (this->currAnim > -1 && this->clips.size() > 0)
+  if (this->cursorAnim != this->currAnim)
   {
-    this->clips[this->currAnim].sample(this->pose, elapsed);
+    // clear keeps the cursor's storage for the next clip
+    this->cursor.tracks.clear();
+    this->cursorAnim = this->currAnim;
   }
-}
+  this->sample(this->pose, this->cursor, this->currAnim, elapsed);
 
-std::vector<Mat4x4> Model::getPose()
-{
-  std::vector<Mat4x4> result;
+  if (this->fadeAnim > -1)
+  {
+    if (this->fadeStart < 0.0f)
+    {
+      this->fadeStart = elapsed;
+    }
+    float t = this->fadeDuration > 0.0f ? (elapsed - this->fadeStart) / this->fadeDuration : 1.0f;
+    if (t >= 1.0f || t < 0.0f)
+    {
+      this->fadeAnim = -1;
+    }
+    else
+    {
+      Pose &from = this->pool.acquire(this->skeleton.restPose);
+      this->sample(from, this->fadeCursor, this->fadeAnim, elapsed);
+      blendPose(this->pose, from, this->pose, t);
+      this->pool.release(from);
+    }
+  }
 
-  if ((this->currAnim > -1) && (this->clips.size() > 0))
+  for (AnimationLayer &layer : this->layers)
   {
-    int len = this->pose.size();
-    result.resize(len, identity());
-    for (int i = 0; i < len; ++i)
+    if (layer.clip < 0 || layer.clip >= (int)this->clips.size() || layer.weight <= 0.0f)
     {
-      Transform world = this->pose.getGlobalTranform(i);
-      Mat4x4 invPose = this->skeleton.inversePose[i];
+      continue;
+    }
 
-      result[i] = world.get() * invPose;
+    Pose &layerPose = this->pool.acquire(this->skeleton.restPose);
+    this->sample(layerPose, layer.cursor, layer.clip, elapsed);
+
+    if (layer.additive)
+    {
+      if (layer.referenceClip != layer.clip || layer.reference.size() != layerPose.size())
+      {
+        ClipCursor start;
+        Clip &clip = this->clips[layer.clip];
+        this->sample(layer.reference, start, layer.clip, clip.GetStartTime());
+        layer.referenceClip = layer.clip;
+      }
+      makeAdditivePose(layerPose, layerPose, layer.reference);
+      if (layer.mask.empty())
+      {
+        addPose(this->pose, this->pose, layerPose, layer.weight);
+      }
+      else
+      {
+        addPose(this->pose, this->pose, layerPose, layer.weight, layer.mask);
+      }
+    }
+    else if (layer.mask.empty())
+    {
+      blendPose(this->pose, this->pose, layerPose, layer.weight);
     }
+    else
+    {
+      blendPose(this->pose, this->pose, layerPose, layer.weight, layer.mask);
+    }
+    this->pool.release(layerPose);
+  }
+}
+
+void Model::crossFade(int clip, float duration)
+{
+  if (clip == this->currAnim)
+  {
+    return;
   }
 
-  return result;
+  // the playing clip's cursor moves over to the fade, swapping keeps both
+  // allocations
+  std::swap(this->cursor, this->fadeCursor);
+  this->cursor.tracks.clear();
+  this->fadeAnim = this->currAnim;
+  this->fadeStart = -1.0f;
+  this->fadeDuration = duration;
+
+  this->currAnim = clip;
+  this->cursorAnim = clip;
+}
+
+size_t Model::jointCount() { return this->skeleton.restPose.size(); }
+
+bool Model::isAnimated() { return this->currAnim > -1 && this->clips.size() > 0; }
+
+void Model::getPose(std::span<Mat3x4> out)
+{
+  if (this->world.size() != this->pose.size())
+  {
+    this->world.resize(this->pose.size());
+  }
+  this->getPose(this->pose, this->world, out);
+}
+
+bool Model::getNormalPose(std::span<const Mat3x4> palette, std::span<Mat3x3> out)
+{
+  if (isRigidBatch(palette))
+  {
+    return false;
+  }
+  normalBatch(palette, out);
+  return true;
+}
+
+void Model::getDualPose(std::span<DualQuat> out)
+{
+  if (this->world.size() != this->pose.size())
+  {
+    this->world.resize(this->pose.size());
+  }
+  this->getDualPose(this->pose, this->world, out);
+}
+
+void Model::sample(Pose &pose, ClipCursor &cursor, int clip, float time, std::span<const uint8_t> active)
+{
+  if (active.empty())
+  {
+    pose = this->skeleton.restPose;
+  }
+  if (clip > -1 && clip < (int)this->clips.size())
+  {
+    this->clips[clip].sample(pose, time, cursor, active);
+  }
+}
+
+void Model::getPose(Pose &pose, std::span<Transform> world, std::span<Mat3x4> out)
+{
+  pose.getGlobalTransforms(world);
+  getBatch(world, out);
+  mulBatch(out, this->skeleton.inversePose, out);
+}
+
+void Model::getDualPose(Pose &pose, std::span<Transform> world, std::span<DualQuat> out)
+{
+  pose.getGlobalTransforms(world);
+  getBatch(world, out);
+  mulBatch(out, this->skeleton.inverseDualPose, out);
 }
 
 void Model::clean()
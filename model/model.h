@@ -1,6 +1,9 @@
 #ifndef MODEL_H
 #define MODEL_H
 
+#include "../math/dualQuat.h"
+#include "../math/mat3.h"
+#include "../math/mat3x4.h"
 #include "../math/mat4.h"
 #include "../math/quaternion.h"
 #include "../math/vec3.h"
@@ -9,6 +12,7 @@
 #include "animation/animation.h"
 #include "foreign/gltf.h"
 
+#include <span>
 #include <vector>
 
 enum ModelType
@@ -17,6 +21,12 @@ enum ModelType
   ModelOBJ,
 };
 
+enum SkinningMode
+{
+  SkinLinear,
+  SkinDualQuat,
+};
+
 class Model
 {
 public:
@@ -31,15 +41,51 @@ public:
   void clean();
 
   void animate(float elapsed);
+  /// @brief switches currAnim to clip, blending out of the playing clip
+  /// over duration seconds of animate time
+  void crossFade(int clip, float duration);
 
   Mat4x4 get_transform();
+  /// @brief inverse transpose of get_transform, for normals
+  Mat3x3 get_normal_transform();
+
+  // the palettes below are written to caller owned spans of jointCount()
+  // entries so a caller can allocate them once and reuse them every frame
+
+  size_t jointCount();
+  /// @brief whether a clip is playing, the palettes are only meaningful then
+  bool isAnimated();
+
+  /// @brief skin palette, one affine matrix per joint
+  void getPose(std::span<Mat3x4> out);
+  /// @brief per joint normal matrices for a palette from getPose. returns
+  /// false and leaves out alone when every joint is a rotation times a
+  /// uniform scale, the palette then carries normals itself
+  bool getNormalPose(std::span<const Mat3x4> palette, std::span<Mat3x3> out);
+  /// @brief skin palette for SkinDualQuat, one dual quaternion per joint.
+  /// joint scaling is dropped
+  void getDualPose(std::span<DualQuat> out);
+
+  // per instance versions for callers that keep their own playback state
+  // (see Animator). they only read the model, several threads can use one
+  // model at the same time
 
-  std::vector<Mat4x4> getPose();
+  /// @brief rest pose with clip sampled at time on top, any clip outside
+  /// clips leaves the rest pose. with an active mask pose is not reset,
+  /// joints with a 0 in it keep their value from the last sample of pose,
+  /// which has to be of the same clip (see Clip::sample)
+  void sample(Pose &pose, ClipCursor &cursor, int clip, float time, std::span<const uint8_t> active = {});
+  /// @brief world needs pose.size() entries and is overwritten
+  void getPose(Pose &pose, std::span<Transform> world, std::span<Mat3x4> out);
+  void getDualPose(Pose &pose, std::span<Transform> world, std::span<DualQuat> out);
 
   std::vector<Mesh> meshes;
   std::vector<Texture> textures;
   std::vector<Clip> clips;
   int currAnim;
+  /// @brief applied in order on top of currAnim by animate
+  std::vector<AnimationLayer> layers;
+  SkinningMode skinning;
 
   Color3f color;
   Skeleton skeleton;
@@ -47,6 +93,19 @@ public:
 private:
   class Transform *transform;
   Pose pose;
+  // keyframe cursors of currAnim, reset when it changes
+  ClipCursor cursor;
+  int cursorAnim;
+  // clip being faded out by crossFade, -1 when not fading. fadeStart is
+  // set by the first animate after crossFade
+  int fadeAnim;
+  float fadeStart;
+  float fadeDuration;
+  ClipCursor fadeCursor;
+  // temporaries of animate's blends
+  PosePool pool;
+  // world transforms of pose, sized on the first frame
+  std::vector<Transform> world;
 };
 
 #endif
@@ -0,0 +1,128 @@
+#include "animationTexture.h"
+#include "../model.h"
+#include "../../math/batch.h"
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+#include <algorithm>
+#include <cmath>
+
+void AnimationTexture::bake(Model &model, float rate)
+{
+  this->joints = model.jointCount();
+  this->clips.clear();
+  this->frames.clear();
+  this->rows = 0;
+
+  Pose pose;
+  std::vector<Transform> world(this->joints);
+  for (size_t i = 0; i < model.clips.size(); i++)
+  {
+    Clip &clip = model.clips[i];
+    BakedClip baked;
+    baked.firstRow = this->rows;
+    baked.startTime = clip.GetStartTime();
+    baked.duration = std::max(clip.GetDuration(), 0.0f);
+    baked.looping = clip.GetLooping();
+    baked.frames = baked.duration > 0.0f ? std::max((size_t)roundf(baked.duration * rate), (size_t)1) + 1 : 1;
+
+    this->frames.resize((this->rows + baked.frames) * this->joints);
+    ClipCursor cursor;
+    for (size_t f = 0; f < baked.frames; f++)
+    {
+      float time = baked.startTime;
+      if (baked.frames > 1)
+      {
+        time += baked.duration * (float)f / (float)(baked.frames - 1);
+      }
+      model.sample(pose, cursor, (int)i, time);
+      model.getPose(pose, world, std::span<Mat3x4>(&this->frames[(this->rows + f) * this->joints], this->joints));
+    }
+
+    this->rows += baked.frames;
+    this->clips.push_back(baked);
+  }
+}
+
+void AnimationTexture::frameAt(const BakedClip &clip, float time, size_t &row, float &t)
+{
+  // same steps as animationBaked.vs
+  float local = time - clip.startTime;
+  if (clip.duration <= 0.0f)
+  {
+    local = 0.0f;
+  }
+  else if (clip.looping)
+  {
+    local -= clip.duration * floorf(local / clip.duration);
+  }
+  else
+  {
+    local = std::clamp(local, 0.0f, clip.duration);
+  }
+
+  float position = clip.duration > 0.0f ? local / clip.duration * (float)(clip.frames - 1) : 0.0f;
+  size_t frame = std::min((size_t)position, clip.frames > 1 ? clip.frames - 2 : 0);
+  row = clip.firstRow + frame;
+  t = std::clamp(position - (float)frame, 0.0f, 1.0f);
+}
+
+void AnimationTexture::sample(size_t clip, float time, std::span<Mat3x4> out)
+{
+  const BakedClip &baked = this->clips[clip];
+  size_t row;
+  float t;
+  this->frameAt(baked, time, row, t);
+
+  size_t next = baked.frames > 1 ? row + 1 : row;
+  std::span<const Mat3x4> a(&this->frames[row * this->joints], this->joints);
+  std::span<const Mat3x4> b(&this->frames[next * this->joints], this->joints);
+  lerpBatch(a, b, t, out);
+}
+
+void AnimationTexture::getClipTable(std::span<Vector4f> out)
+{
+  for (size_t i = 0; i < this->clips.size() && i < out.size(); i++)
+  {
+    const BakedClip &clip = this->clips[i];
+    float duration = clip.looping ? clip.duration : -clip.duration;
+    out[i] = Vector4f((float)clip.firstRow, (float)clip.frames, clip.startTime, duration);
+  }
+}
+
+void AnimationTexture::upload()
+{
+  int maxSize = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+  if ((int)this->width() > maxSize || (int)this->height() > maxSize)
+  {
+    std::cout << "animation texture of " << this->width() << "x" << this->height()
+              << " is over the limit of " << maxSize << ", lower the bake rate" << std::endl;
+  }
+
+  glGenTextures(1, &this->id);
+  glBindTexture(GL_TEXTURE_2D, this->id);
+
+  // fetched with texelFetch, the shader blends frames itself
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, (int)this->width(), (int)this->height(), 0,
+               GL_RGBA, GL_FLOAT, this->frames.data());
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void AnimationTexture::bind(unsigned int unit)
+{
+  glActiveTexture(GL_TEXTURE0 + unit);
+  glBindTexture(GL_TEXTURE_2D, this->id);
+}
+
+void AnimationTexture::clean() { glDeleteTextures(1, &this->id); }
+
+size_t AnimationTexture::jointCount() { return this->joints; }
+size_t AnimationTexture::width() { return this->joints * 3; }
+size_t AnimationTexture::height() { return this->rows; }
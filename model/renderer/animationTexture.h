@@ -0,0 +1,72 @@
+#ifndef ANIMATION_TEXTURE_H
+#define ANIMATION_TEXTURE_H
+
+#include "../../math/mat3x4.h"
+#include "../../math/vec4.h"
+
+#include <span>
+#include <vector>
+
+// clip table entries shaders/animationBaked.vs has room for
+#define MAX_BAKED_CLIPS 64
+
+/// @brief where the frames of one clip sit in an AnimationTexture
+struct BakedClip
+{
+  size_t firstRow;
+  size_t frames;
+  float startTime;
+  float duration;
+  bool looping;
+};
+
+/// @brief the skin palettes of every clip of a model, sampled at a fixed rate
+/// and kept in one float texture for instanced crowds. a row is one frame
+/// with three RGBA texels per joint (the rows of its Mat3x4), the clips'
+/// frames are stacked in clip order. shaders/animationBaked.vs fetches the
+/// frames on either side of an instance's time and lerps them, so playback
+/// costs the cpu nothing. palettes are linear blend skinning matrices, also
+/// for SkinDualQuat models
+class AnimationTexture
+{
+public:
+  AnimationTexture() : id(0), joints(0), rows(0) {}
+  ~AnimationTexture() {}
+
+  /// @brief samples every clip of model from its start to its end at about
+  /// rate frames per second, each clip's rate adjusted so its last frame
+  /// lands on its end. needs no gl context
+  void bake(class Model &model, float rate);
+  /// @brief palette of clip at time (clip time, like Clip::sample), lerped
+  /// between frames the way the shader does. out needs jointCount() entries
+  void sample(size_t clip, float time, std::span<Mat3x4> out);
+
+  /// @brief creates the GL_RGBA32F texture from the baked frames
+  void upload();
+  void bind(unsigned int unit);
+  void clean();
+
+  size_t jointCount();
+  /// @brief texels per row, 3 per joint
+  size_t width();
+  /// @brief frames of all clips
+  size_t height();
+  /// @brief clip table for the shader's clips uniform, one entry per clip:
+  /// first row, frame count, start time and duration, the duration negated
+  /// for clips that do not loop
+  void getClipTable(std::span<Vector4f> out);
+
+  std::vector<BakedClip> clips;
+  /// @brief the palettes of every row, jointCount() per row
+  std::vector<Mat3x4> frames;
+  unsigned int id;
+
+private:
+  size_t joints;
+  size_t rows;
+
+  /// @brief row of the frame before time and the blend factor to the next
+  void frameAt(const BakedClip &clip, float time, size_t &row, float &t);
+};
+
+#endif
@@ -94,6 +94,51 @@ void Mesh::render()
   }
 }
 
+void Mesh::setInstances(uint buffer)
+{
+  glBindVertexArray(VAO);
+  glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+  for (uint row = 0; row < 4; row++)
+  {
+    glVertexAttribPointer(5 + row, 4, GL_FLOAT, GL_FALSE, sizeof(MeshInstance),
+                          (void *)(offsetof(MeshInstance, transform) + sizeof(float) * 4 * row));
+    glEnableVertexAttribArray(5 + row);
+    glVertexAttribDivisor(5 + row, 1);
+  }
+
+  glVertexAttribPointer(9, 2, GL_FLOAT, GL_FALSE, sizeof(MeshInstance),
+                        (void *)offsetof(MeshInstance, animation));
+  glEnableVertexAttribArray(9);
+  glVertexAttribDivisor(9, 1);
+
+  // from the packed rc elements, Mat3x3's padded rows do not match them
+  for (uint row = 0; row < 3; row++)
+  {
+    glVertexAttribPointer(10 + row, 3, GL_FLOAT, GL_FALSE, sizeof(MeshInstance),
+                          (void *)(offsetof(MeshInstance, normal) + sizeof(float) * 3 * row));
+    glEnableVertexAttribArray(10 + row);
+    glVertexAttribDivisor(10 + row, 1);
+  }
+
+  glBindVertexArray(0);
+}
+void Mesh::renderInstanced(size_t count)
+{
+  GLenum primitive = mode == POINTS ? GL_POINTS : mode == LINES ? GL_LINES : GL_TRIANGLES;
+
+  glBindVertexArray(VAO);
+  if (mode != POINTS && indices.size() != 0)
+  {
+    glDrawElementsInstanced(primitive, indices.size(), GL_UNSIGNED_INT, 0, count);
+  }
+  else
+  {
+    glDrawArraysInstanced(primitive, 0, vertices.size(), count);
+  }
+  glBindVertexArray(0);
+}
+
 void Mesh::clean()
 {
   glDeleteVertexArrays(1, &VAO);
@@ -5,6 +5,7 @@
 #include <iostream>
 #include <vector>
 
+#include "../../math/mat3.h"
 #include "../../math/mat4.h"
 #include "../../math/vec2.h"
 #include "../../math/vec3.h"
@@ -20,6 +21,18 @@ struct Vertex
   int joints[4] = {-1, -1, -1, -1};
 };
 
+/// @brief per instance attributes of Mesh::renderInstanced
+struct MeshInstance
+{
+  /// @brief row-major like every Mat4x4, one row per location from 5 to 8
+  Mat4x4 transform;
+  /// @brief location 9, baked clip and time offset for animationBaked.vs
+  Vector2f animation;
+  /// @brief inverse transpose of transform, rows at locations 10 to 12 so
+  /// the vertex shader does not invert it per vertex
+  Mat3x3 normal;
+};
+
 enum DrawMode
 {
   POINTS,
@@ -40,6 +53,11 @@ struct Mesh
 
   void init();
   void render();
+  /// @brief sources attributes 5 to 12 from buffer, an array of MeshInstance,
+  /// advancing once per instance. call again when buffer is recreated
+  void setInstances(uint buffer);
+  /// @brief draws count instances from the buffer of setInstances
+  void renderInstanced(size_t count);
   void clean();
 };
 
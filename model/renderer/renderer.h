@@ -2,3 +2,4 @@
 #include "shader.h"
 #include "texture.h"
 #include "material.h"
+#include "animationTexture.h"
@@ -2,6 +2,8 @@
 
 #include <GL/gl.h>
 
+#include <algorithm>
+#include <cstdio>
 #include <fstream>
 #include <sstream>
 #include <string>
@@ -14,13 +16,85 @@ Shader::Shader(const char *vert_path, const char *frag_path) : program(0)
 }
 
 void Shader::use() { glUseProgram(program); }
-void Shader::clean() { glDeleteProgram(program); }
+void Shader::clean()
+{
+  glDeleteProgram(program);
+  for (auto &buffer : this->storage)
+  {
+    glDeleteBuffers(1, &buffer.second);
+  }
+  this->storage.clear();
+}
 
+void Shader::updateMat3(const char *name, const Mat3x3 &mat)
+{
+  unsigned int location = glGetUniformLocation(program, name);
+  glUniformMatrix3fv(location, 1, true, &mat.rc[0][0]);
+}
 void Shader::updateMat4(const char *name, const Mat4x4 &mat)
 {
   unsigned int location = glGetUniformLocation(program, name);
   glUniformMatrix4fv(location, 1, true, &mat.rc[0][0]);
 }
+// uploaded untransposed: each row lands in a column of the glsl mat3x4, so
+// shaders apply it as vec4 * mat
+void Shader::updateMat3x4(const char *name, const Mat3x4 &mat)
+{
+  unsigned int location = glGetUniformLocation(program, name);
+  glUniformMatrix3x4fv(location, 1, false, &mat.rc[0][0]);
+}
+void Shader::updateDualQuat(const char *name, const DualQuat &dq)
+{
+  unsigned int location = glGetUniformLocation(program, name);
+  glUniformMatrix2x4fv(location, 1, false, &dq.real.v[0]);
+}
+void Shader::updateMat3(const char *name, std::span<const Mat3x3> mats)
+{
+  // Mat3x3 rows are padded, repack a chunk at a time into tight 3x3 blocks
+  const size_t chunk = 32;
+  float packed[chunk * 9];
+  char element[128];
+
+  for (size_t first = 0; first < mats.size(); first += chunk)
+  {
+    size_t count = std::min(chunk, mats.size() - first);
+    for (size_t i = 0; i < count; i++)
+    {
+      for (int r = 0; r < 3; r++)
+      {
+        for (int c = 0; c < 3; c++)
+        {
+          packed[i * 9 + r * 3 + c] = mats[first + i].rc[r][c];
+        }
+      }
+    }
+    snprintf(element, sizeof(element), "%s[%zu]", name, first);
+    unsigned int location = glGetUniformLocation(program, element);
+    glUniformMatrix3fv(location, (int)count, true, packed);
+  }
+}
+// both are uploaded straight from the array, elements must be tightly packed
+static_assert(sizeof(Mat3x4) == 12 * sizeof(float));
+static_assert(sizeof(DualQuat) == 8 * sizeof(float));
+
+void Shader::updateMat3x4(const char *name, std::span<const Mat3x4> mats)
+{
+  if (mats.empty())
+  {
+    return;
+  }
+  unsigned int location = glGetUniformLocation(program, name);
+  glUniformMatrix3x4fv(location, (int)mats.size(), false, &mats.data()->rc[0][0]);
+}
+void Shader::updateDualQuat(const char *name, std::span<const DualQuat> dqs)
+{
+  if (dqs.empty())
+  {
+    return;
+  }
+  unsigned int location = glGetUniformLocation(program, name);
+  glUniformMatrix2x4fv(location, (int)dqs.size(), false, &dqs.data()->real.v[0]);
+}
 void Shader::updateVec3(const char *name, const Vector3f &vec)
 {
   unsigned int location = glGetUniformLocation(program, name);
@@ -31,6 +105,78 @@ void Shader::updateFloat(const char *name, float value)
   unsigned int location = glGetUniformLocation(program, name);
   glUniform1f(location, value);
 }
+void Shader::updateVec4(const char *name, std::span<const Vector4f> vecs)
+{
+  if (vecs.empty())
+  {
+    return;
+  }
+  unsigned int location = glGetUniformLocation(program, name);
+  glUniform4fv(location, (int)vecs.size(), &vecs.data()->v[0]);
+}
+void Shader::bindStorage(const char *name)
+{
+  auto found = this->storage.find(name);
+  if (found == this->storage.end())
+  {
+    unsigned int buffer;
+    glGenBuffers(1, &buffer);
+    found = this->storage.emplace(name, buffer).first;
+  }
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, found->second);
+
+  // the binding point is set by the block's layout qualifier
+  unsigned int block = glGetProgramResourceIndex(program, GL_SHADER_STORAGE_BLOCK, name);
+  if (block != GL_INVALID_INDEX)
+  {
+    GLenum property = GL_BUFFER_BINDING;
+    int binding = 0;
+    glGetProgramResourceiv(program, GL_SHADER_STORAGE_BLOCK, block, 1, &property, 1, nullptr, &binding);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, found->second);
+  }
+}
+void Shader::updateStorage(const char *name, std::span<const Mat3x4> mats)
+{
+  if (mats.empty())
+  {
+    return;
+  }
+  this->bindStorage(name);
+  // a fresh store every call, draws still reading the old one keep it
+  glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(Mat3x4) * mats.size(), mats.data(), GL_STREAM_DRAW);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+void Shader::updateStorage(const char *name, std::span<const Mat3x3> mats)
+{
+  if (mats.empty())
+  {
+    return;
+  }
+  this->bindStorage(name);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(float) * 12 * mats.size(), nullptr, GL_STREAM_DRAW);
+
+  // std430 row_major mat3 rows are padded to 4 floats, repacked a chunk at a
+  // time like updateMat3
+  const size_t chunk = 32;
+  float packed[chunk * 12];
+  for (size_t first = 0; first < mats.size(); first += chunk)
+  {
+    size_t count = std::min(chunk, mats.size() - first);
+    for (size_t i = 0; i < count; i++)
+    {
+      for (int r = 0; r < 3; r++)
+      {
+        for (int c = 0; c < 3; c++)
+        {
+          packed[i * 12 + r * 4 + c] = mats[first + i].rc[r][c];
+        }
+        packed[i * 12 + r * 4 + 3] = 0.0f;
+      }
+    }
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(float) * 12 * first, sizeof(float) * 12 * count, packed);
+  }
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
 void Shader::updateInt(const char *name, int value)
 {
   unsigned int location = glGetUniformLocation(program, name);
@@ -83,6 +229,17 @@ void Shader::load(const char *vert_path, const char *frag_path)
   glAttachShader(program, fragment);
   glLinkProgram(program);
 
+  // a vertex shader over the driver's uniform limits only fails here
+  int linked = 0;
+  glGetProgramiv(program, GL_LINK_STATUS, &linked);
+  if (!linked)
+  {
+    char log[1024];
+    glGetProgramInfoLog(program, sizeof(log), NULL, log);
+    std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED " << vert_path << "\n"
+              << log << std::endl;
+  }
+
   glDeleteShader(vertex);
   glDeleteShader(fragment);
 }
@@ -1,9 +1,16 @@
 #ifndef SHADER
 #define SHADER
 
+#include "../../math/dualQuat.h"
+#include "../../math/mat3.h"
+#include "../../math/mat3x4.h"
 #include "../../math/mat4.h"
 #include "../../math/vec3.h"
+#include "../../math/vec4.h"
 #include <iostream>
+#include <map>
+#include <span>
+#include <string>
 
 class Shader
 {
@@ -21,8 +28,34 @@ public:
   void updateInt(const char *name, int value);
   void updateFloat(const char *name, float value);
   void updateVec3(const char *name, const Vector3f &vec);
+  void updateMat3(const char *name, const Mat3x3 &mat);
   void updateMat4(const char *name, const Mat4x4 &mat);
+  void updateMat3x4(const char *name, const Mat3x4 &mat);
+  /// @brief uploads to a mat2x4, real part in the first column
+  void updateDualQuat(const char *name, const DualQuat &dq);
+
+  // whole uniform arrays starting at element 0 of name, without building a
+  // name string per element
+  void updateMat3(const char *name, std::span<const Mat3x3> mats);
+  void updateMat3x4(const char *name, std::span<const Mat3x4> mats);
+  void updateDualQuat(const char *name, std::span<const DualQuat> dqs);
+  void updateVec4(const char *name, std::span<const Vector4f> vecs);
+
+  // whole arrays into the shader storage block named name, for arrays too
+  // large for the default uniform block (skin palettes). the buffers belong
+  // to the shader, one per block, and bind to the block's binding point
+
+  /// @brief a std430 mat3x4 array, each row lands in a column like
+  /// updateMat3x4
+  void updateStorage(const char *name, std::span<const Mat3x4> mats);
+  /// @brief a std430 row_major mat3 array
+  void updateStorage(const char *name, std::span<const Mat3x3> mats);
 
 private:
+  std::map<std::string, unsigned int> storage;
+
+  /// @brief binds the buffer of block name, created on first use, and
+  /// leaves it bound to GL_SHADER_STORAGE_BUFFER
+  void bindStorage(const char *name);
 };
 #endif
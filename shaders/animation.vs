@@ -10,26 +10,50 @@ uniform mat4 transform;
 uniform mat4 view;
 uniform mat4 projection;
 uniform mat4 lightSpace;
+// inverse transpose of transform, computed once per draw on the cpu
+uniform mat3 normalMat;
 
 out vec3 normal;
 out vec3 fragPos;
 out vec2 texCoords;
 
-const int MAX_BONES = 300;
 const int MAX_BONE_INFLUENCE = 4;
-uniform mat4 boneMats[MAX_BONES];
+// the palettes live in storage buffers sized to the skeleton (see
+// Shader::updateStorage), as uniform arrays they would run over the vertex
+// uniform limit of many drivers
+
+// affine bone matrices, each column holds one row of the cpu side matrix
+layout(std430, binding = 0) readonly buffer BoneMats {
+    mat3x4 boneMats[];
+};
+// set when every bone is a rotation times a uniform scale, the blended bone
+// matrix then carries normals as is (they get normalized in the fragment
+// shader). otherwise the per bone normal matrices are blended instead
+uniform bool rigidBones;
+layout(std430, binding = 1, row_major) readonly buffer BoneNormals {
+    mat3 boneNormals[];
+};
 
 void main() {
 
-    mat4 skin = boneMats[boneIds[0]] * weights[0];
-    skin += boneMats[boneIds[1]] * weights[1];
-    skin += boneMats[boneIds[2]] * weights[2];
-    skin += boneMats[boneIds[3]] * weights[3];
+    mat3x4 bones = boneMats[boneIds[0]] * weights[0];
+    bones += boneMats[boneIds[1]] * weights[1];
+    bones += boneMats[boneIds[2]] * weights[2];
+    bones += boneMats[boneIds[3]] * weights[3];
+
+    mat4 skin = transpose(mat4(bones[0], bones[1], bones[2], vec4(0.0, 0.0, 0.0, 1.0)));
 
     mat4 final_mat = transform * skin;
     gl_Position = projection * view * final_mat * vec4(pos, 1.0);
 
-    normal = mat3(transpose(inverse(final_mat))) * norm;
+    mat3 skinNormal = mat3(skin);
+    if (!rigidBones) {
+        skinNormal = boneNormals[boneIds[0]] * weights[0];
+        skinNormal += boneNormals[boneIds[1]] * weights[1];
+        skinNormal += boneNormals[boneIds[2]] * weights[2];
+        skinNormal += boneNormals[boneIds[3]] * weights[3];
+    }
+    normal = normalMat * (skinNormal * norm);
     texCoords = tc;
 
     fragPos = vec3(final_mat * vec4(pos, 1.0));
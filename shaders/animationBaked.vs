@@ -0,0 +1,90 @@
+#version 460
+
+layout(location = 0) in vec3 pos;
+layout(location = 1) in vec3 norm;
+layout(location = 2) in vec2 tc;
+layout(location = 3) in vec4 weights;
+layout(location = 4) in ivec4 boneIds;
+// per instance, see MeshInstance. rows of the row-major model matrix, the
+// baked clip and a time offset, then rows of the model matrix's inverse
+// transpose
+layout(location = 5) in vec4 instanceRow0;
+layout(location = 6) in vec4 instanceRow1;
+layout(location = 7) in vec4 instanceRow2;
+layout(location = 8) in vec4 instanceRow3;
+layout(location = 9) in vec2 instanceAnimation;
+layout(location = 10) in vec3 instanceNormal0;
+layout(location = 11) in vec3 instanceNormal1;
+layout(location = 12) in vec3 instanceNormal2;
+
+uniform mat4 view;
+uniform mat4 projection;
+// shared by every instance, each adds its own offset
+uniform float time;
+
+out vec3 normal;
+out vec3 fragPos;
+out vec2 texCoords;
+
+const int MAX_BAKED_CLIPS = 64;
+// skin palettes of an AnimationTexture, a row per frame and three texels per
+// joint, each the row of a cpu side Mat3x4
+uniform sampler2D animationTexture;
+// first row, frame count, start time and duration of every baked clip, the
+// duration is negative for clips that do not loop
+uniform vec4 clips[MAX_BAKED_CLIPS];
+
+mat3x4 boneAt(int row, int bone) {
+    return mat3x4(texelFetch(animationTexture, ivec2(bone * 3, row), 0),
+                  texelFetch(animationTexture, ivec2(bone * 3 + 1, row), 0),
+                  texelFetch(animationTexture, ivec2(bone * 3 + 2, row), 0));
+}
+
+// both frames blended first, then the frames' palettes lerped, same as
+// AnimationTexture::sample
+mat3x4 skinAt(int row, int next, float t) {
+    mat3x4 a = boneAt(row, boneIds[0]) * weights[0];
+    a += boneAt(row, boneIds[1]) * weights[1];
+    a += boneAt(row, boneIds[2]) * weights[2];
+    a += boneAt(row, boneIds[3]) * weights[3];
+
+    mat3x4 b = boneAt(next, boneIds[0]) * weights[0];
+    b += boneAt(next, boneIds[1]) * weights[1];
+    b += boneAt(next, boneIds[2]) * weights[2];
+    b += boneAt(next, boneIds[3]) * weights[3];
+
+    return a + (b - a) * t;
+}
+
+void main() {
+    vec4 clip = clips[int(instanceAnimation.x)];
+    int frames = int(clip.y);
+    float duration = abs(clip.w);
+
+    float local = time + instanceAnimation.y - clip.z;
+    if (clip.w > 0.0) {
+        local = mod(local, duration);
+    } else {
+        local = clamp(local, 0.0, duration);
+    }
+    float position = duration > 0.0 ? local / duration * float(frames - 1) : 0.0;
+    int frame = min(int(position), max(frames - 2, 0));
+    float t = clamp(position - float(frame), 0.0, 1.0);
+    int row = int(clip.x) + frame;
+    int next = frames > 1 ? row + 1 : row;
+
+    mat3x4 bones = skinAt(row, next, t);
+    mat4 skin = transpose(mat4(bones[0], bones[1], bones[2], vec4(0.0, 0.0, 0.0, 1.0)));
+    mat4 instance = transpose(mat4(instanceRow0, instanceRow1, instanceRow2, instanceRow3));
+
+    mat4 final_mat = instance * skin;
+    gl_Position = projection * view * final_mat * vec4(pos, 1.0);
+
+    // baked palettes carry no normal matrices, bones are taken to be
+    // rotations times a uniform scale like rigidBones in animation.vs
+    mat3 normalMat = transpose(mat3(instanceNormal0, instanceNormal1, instanceNormal2));
+    normal = normalMat * (mat3(skin) * norm);
+    texCoords = tc;
+
+    fragPos = vec3(final_mat * vec4(pos, 1.0));
+}
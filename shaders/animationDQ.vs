@@ -0,0 +1,62 @@
+#version 460
+
+layout(location = 0) in vec3 pos;
+layout(location = 1) in vec3 norm;
+layout(location = 2) in vec2 tc;
+layout(location = 3) in vec4 weights;
+layout(location = 4) in ivec4 boneIds;
+
+uniform mat4 transform;
+uniform mat4 view;
+uniform mat4 projection;
+uniform mat4 lightSpace;
+// inverse transpose of transform, computed once per draw on the cpu
+uniform mat3 normalMat;
+
+out vec3 normal;
+out vec3 fragPos;
+out vec2 texCoords;
+
+const int MAX_BONES = 300;
+const int MAX_BONE_INFLUENCE = 4;
+// dual quaternion bones, real part (x, y, z, s) in column 0, dual part in column 1
+uniform mat2x4 boneDQs[MAX_BONES];
+
+// rotation and translation of a unit dual quaternion as a matrix
+mat4 dualQuatToMat4(vec4 r, vec4 d) {
+    vec3 t = 2.0 * (r.w * d.xyz - d.w * r.xyz + cross(r.xyz, d.xyz));
+
+    vec3 x = vec3(1.0 - 2.0 * (r.y * r.y + r.z * r.z), 2.0 * (r.x * r.y + r.w * r.z), 2.0 * (r.x * r.z - r.w * r.y));
+    vec3 y = vec3(2.0 * (r.x * r.y - r.w * r.z), 1.0 - 2.0 * (r.x * r.x + r.z * r.z), 2.0 * (r.y * r.z + r.w * r.x));
+    vec3 z = vec3(2.0 * (r.x * r.z + r.w * r.y), 2.0 * (r.y * r.z - r.w * r.x), 1.0 - 2.0 * (r.x * r.x + r.y * r.y));
+
+    return mat4(vec4(x, 0.0), vec4(y, 0.0), vec4(z, 0.0), vec4(t, 1.0));
+}
+
+void main() {
+
+    mat2x4 dq0 = boneDQs[boneIds[0]];
+    mat2x4 dq1 = boneDQs[boneIds[1]];
+    mat2x4 dq2 = boneDQs[boneIds[2]];
+    mat2x4 dq3 = boneDQs[boneIds[3]];
+
+    // q and -q are the same rotation, keep every influence in the hemisphere
+    // of the first one so the blend does not take the long way around
+    float w1 = dot(dq0[0], dq1[0]) < 0.0 ? -weights[1] : weights[1];
+    float w2 = dot(dq0[0], dq2[0]) < 0.0 ? -weights[2] : weights[2];
+    float w3 = dot(dq0[0], dq3[0]) < 0.0 ? -weights[3] : weights[3];
+
+    mat2x4 blended = dq0 * weights[0] + dq1 * w1 + dq2 * w2 + dq3 * w3;
+    blended /= length(blended[0]);
+
+    mat4 skin = dualQuatToMat4(blended[0], blended[1]);
+
+    mat4 final_mat = transform * skin;
+    gl_Position = projection * view * final_mat * vec4(pos, 1.0);
+
+    // dual quaternions are rigid, the rotation carries normals as is
+    normal = normalMat * (mat3(skin) * norm);
+    texCoords = tc;
+
+    fragPos = vec3(final_mat * vec4(pos, 1.0));
+}
@@ -0,0 +1,325 @@
+#include "animator.h"
+#include "../math/batch.h"
+
+Animator::Animator(size_t threads)
+    : generation(0), remaining(0), running(false), stopping(false), next(0), time(0.0f),
+      jointCoverage(0.0f), hasCamera(false)
+{
+  if (threads == 0)
+  {
+    size_t hardware = std::thread::hardware_concurrency();
+    threads = hardware > 1 ? hardware - 1 : 0;
+  }
+  for (size_t i = 0; i < threads; i++)
+  {
+    this->workers.emplace_back(&Animator::work, this);
+  }
+}
+
+Animator::~Animator()
+{
+  this->finish();
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->stopping = true;
+  }
+  this->wake.notify_all();
+  for (std::thread &worker : this->workers)
+  {
+    worker.join();
+  }
+}
+
+AnimatedInstance &Animator::add(Model *model, const Transform &transform, int clip, float timeOffset)
+{
+  this->finish();
+
+  AnimatedInstance &instance = this->instances.emplace_back();
+  instance.model = model;
+  instance.transform = transform;
+  instance.clip = clip;
+  instance.timeOffset = timeOffset;
+  instance.pose = model->skeleton.restPose;
+  instance.cursorClip = clip;
+  instance.front = 0;
+  instance.coverage = 1.0f;
+  instance.lod = -1;
+  instance.key = 0;
+  instance.keyTime = 0.0f;
+  instance.keyInterval = 0.0f;
+  instance.sampled = false;
+
+  // shared by the instances of the model, the workers only read it
+  if (model->skeleton.jointExtents.size() != model->jointCount())
+  {
+    model->skeleton.computeBounds();
+  }
+
+  // everything a job writes is allocated here, updates do not allocate
+  size_t joints = model->jointCount();
+  instance.world.resize(joints);
+  instance.active.assign(joints, 1);
+  for (SkinPalette *palette : {&instance.palettes[0], &instance.palettes[1], &instance.keys[0], &instance.keys[1]})
+  {
+    palette->mats.resize(joints);
+    palette->normals.resize(joints);
+    palette->dualQuats.resize(joints);
+    palette->rigid = true;
+  }
+  return instance;
+}
+
+size_t Animator::size() { return this->instances.size(); }
+AnimatedInstance &Animator::getInstance(size_t index) { return this->instances[index]; }
+
+void Animator::setLod(const std::vector<AnimationLod> &levels, float jointCoverage)
+{
+  this->finish();
+  this->lods = levels;
+  this->jointCoverage = jointCoverage;
+}
+
+void Animator::setCamera(const Mat4x4 &view, const Mat4x4 &projection)
+{
+  this->finish();
+  this->view = view;
+  this->projection = projection;
+  this->hasCamera = true;
+}
+
+void Animator::begin(float time)
+{
+  this->finish();
+  if (this->instances.empty())
+  {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->time = time;
+    this->next = 0;
+    this->remaining = this->instances.size();
+    this->running = true;
+    this->generation++;
+  }
+  this->wake.notify_all();
+}
+
+void Animator::finish()
+{
+  if (!this->running)
+  {
+    return;
+  }
+
+  // the caller would only wait otherwise
+  this->runJobs();
+  {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->done.wait(lock, [this]()
+                    { return this->remaining == 0; });
+    this->running = false;
+  }
+
+  for (AnimatedInstance &instance : this->instances)
+  {
+    instance.front = 1 - instance.front;
+  }
+}
+
+void Animator::work()
+{
+  size_t seen = 0;
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->wake.wait(lock, [this, seen]()
+                      { return this->stopping || this->generation != seen; });
+      if (this->stopping)
+      {
+        return;
+      }
+      seen = this->generation;
+    }
+    this->runJobs();
+  }
+}
+
+void Animator::runJobs()
+{
+  size_t count = this->instances.size();
+  size_t finished = 0;
+  for (size_t i = this->next++; i < count; i = this->next++)
+  {
+    this->animate(this->instances[i]);
+    finished++;
+  }
+
+  if (finished > 0)
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->remaining -= finished;
+    if (this->remaining == 0)
+    {
+      this->done.notify_all();
+    }
+  }
+}
+
+void Animator::animate(AnimatedInstance &instance)
+{
+  SkinPalette &palette = instance.palettes[1 - instance.front];
+
+  if (instance.cursorClip != instance.clip)
+  {
+    instance.cursor.tracks.clear();
+    instance.cursorClip = instance.clip;
+    instance.keyInterval = 0.0f;
+    instance.sampled = false;
+  }
+
+  float time = this->time + instance.timeOffset;
+  float interval = this->updateLod(instance);
+  if (interval > 0.0f && !this->crossesLoop(instance, time, interval))
+  {
+    this->blendKeys(instance, time, interval, palette);
+  }
+  else
+  {
+    this->samplePalette(instance, time, true, palette);
+    instance.keyInterval = 0.0f;
+  }
+}
+
+void Animator::samplePalette(AnimatedInstance &instance, float time, bool masked, SkinPalette &out)
+{
+  Model *model = instance.model;
+
+  // skipped joints hold on to their last sampled value, which needs a full
+  // sample of the clip first
+  std::span<const uint8_t> active;
+  if (masked && this->jointCoverage > 0.0f && instance.sampled)
+  {
+    active = instance.active;
+  }
+  model->sample(instance.pose, instance.cursor, instance.clip, time, active);
+  instance.sampled = true;
+
+  if (model->skinning == SkinDualQuat)
+  {
+    model->getDualPose(instance.pose, instance.world, out.dualQuats);
+  }
+  else
+  {
+    model->getPose(instance.pose, instance.world, out.mats);
+    out.rigid = !model->getNormalPose(out.mats, out.normals);
+  }
+}
+
+float Animator::updateLod(AnimatedInstance &instance)
+{
+  instance.coverage = this->hasCamera ? this->coverage(instance) : 1.0f;
+  instance.lod = -1;
+  float interval = 0.0f;
+  for (size_t i = 0; i < this->lods.size(); i++)
+  {
+    if (instance.coverage < this->lods[i].coverage)
+    {
+      instance.lod = (int)i;
+      interval = this->lods[i].interval;
+    }
+  }
+
+  if (this->jointCoverage > 0.0f)
+  {
+    std::vector<float> &extents = instance.model->skeleton.jointExtents;
+    for (size_t i = 0; i < instance.active.size(); i++)
+    {
+      instance.active[i] = extents[i] * instance.coverage >= this->jointCoverage;
+    }
+  }
+  return interval;
+}
+
+float Animator::coverage(AnimatedInstance &instance)
+{
+  Skeleton &skeleton = instance.model->skeleton;
+  const Transform &transform = instance.transform;
+  Vector3f scaling = transform.scaling;
+  float scale = max(max(fabsf(scaling.x), fabsf(scaling.y)), fabsf(scaling.z));
+
+  Vector3f center = transform.translation + transform.orientation * (skeleton.boundCenter * scale);
+  Vector4f eye = mat4MulVecScalar(this->view, Vector4f(center.x, center.y, center.z, 1.0f));
+  float radius = skeleton.boundRadius * scale;
+  float depth = -eye.z;
+  if (depth <= radius)
+  {
+    return 1.0f;
+  }
+  // projected diameter over the screen height, both in ndc units
+  return min(radius * this->projection.yy / depth, 1.0f);
+}
+
+bool Animator::crossesLoop(AnimatedInstance &instance, float time, float interval)
+{
+  Model *model = instance.model;
+  if (instance.clip < 0 || instance.clip >= (int)model->clips.size())
+  {
+    return false;
+  }
+  Clip &clip = model->clips[instance.clip];
+  float duration = clip.GetDuration();
+  if (!clip.GetLooping() || duration <= 0.0f)
+  {
+    return false;
+  }
+
+  // the keys would sit on either side of the jump from the clip's end back
+  // to its start (root motion, clips that do not loop cleanly), blending
+  // them passes through poses of neither. sampled every update until past
+  // it
+  float from = floorf((time - clip.GetStartTime()) / duration);
+  float to = floorf((time + interval - clip.GetStartTime()) / duration);
+  return from != to;
+}
+
+void Animator::blendKeys(AnimatedInstance &instance, float time, float interval, SkinPalette &out)
+{
+  float end = instance.keyTime + instance.keyInterval;
+  bool current = instance.keyInterval == interval && time >= instance.keyTime;
+  if (current && time >= end && time < end + interval)
+  {
+    // moved past the later key, it becomes the earlier one
+    instance.key = 1 - instance.key;
+    instance.keyTime = end;
+    this->samplePalette(instance, end + interval, true, instance.keys[1 - instance.key]);
+  }
+  else if (!current || time >= end)
+  {
+    // first use, a seek or another interval
+    instance.key = 0;
+    instance.keyTime = time;
+    instance.keyInterval = interval;
+    this->samplePalette(instance, time, false, instance.keys[0]);
+    this->samplePalette(instance, time + interval, false, instance.keys[1]);
+  }
+
+  const SkinPalette &from = instance.keys[instance.key];
+  const SkinPalette &to = instance.keys[1 - instance.key];
+  float t = (time - instance.keyTime) / interval;
+  if (instance.model->skinning == SkinDualQuat)
+  {
+    lerpBatch(from.dualQuats, to.dualQuats, t, out.dualQuats);
+  }
+  else
+  {
+    lerpBatch(from.mats, to.mats, t, out.mats);
+    out.rigid = from.rigid && to.rigid;
+    if (!out.rigid)
+    {
+      normalBatch(out.mats, out.normals);
+    }
+  }
+}
@@ -0,0 +1,148 @@
+#ifndef ANIMATOR_H
+#define ANIMATOR_H
+
+#include "../model/model.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// @brief skin palette of one instance, sized once when it is added
+struct SkinPalette
+{
+  std::vector<Mat3x4> mats;
+  std::vector<Mat3x3> normals;
+  /// @brief normals was left alone, the mats carry the normals themselves
+  bool rigid;
+  std::vector<DualQuat> dualQuats;
+};
+
+/// @brief one step of animation level of detail
+struct AnimationLod
+{
+  /// @brief applies while an instance's bound covers less than this
+  /// fraction of the screen height
+  float coverage;
+  /// @brief seconds between clip samples, the skin palettes in between are
+  /// blended from the samples on either side. 0 samples every update
+  float interval;
+};
+
+/// @brief one animated character drawn with a shared Model. the model is
+/// only read, all playback state lives here
+struct AnimatedInstance
+{
+  Model *model;
+  Transform transform;
+  /// @brief index into model->clips, -1 for the rest pose
+  int clip;
+  /// @brief added to the animator's time so instances sharing a clip are
+  /// not in lockstep
+  float timeOffset;
+
+  Pose pose;
+  ClipCursor cursor;
+  int cursorClip;
+  std::vector<Transform> world;
+
+  /// @brief the palette finished by the last Animator::finish, safe to read
+  /// while the next update runs
+  const SkinPalette &palette() const { return this->palettes[this->front]; }
+
+  SkinPalette palettes[2];
+  int front;
+
+  /// @brief fraction of the screen height the bound covered at the last
+  /// update and the lod it picked, -1 for full detail
+  float coverage;
+  int lod;
+
+  // lod state: joints that get sampled, and the two palettes the palette is
+  // blended from between samples. keys[key] was sampled at keyTime, the
+  // other one keyInterval later. keyInterval is 0 when the keys are stale
+  std::vector<uint8_t> active;
+  SkinPalette keys[2];
+  int key;
+  float keyTime;
+  float keyInterval;
+  // pose holds a full sample of clip, masked samples only update the
+  // active joints
+  bool sampled;
+};
+
+/// @brief animates every instance on a pool of worker threads. each instance
+/// is one job (sample, global pose, palette) and writes only its own data.
+/// palettes are double buffered: begin starts writing the back buffers,
+/// finish waits and swaps them to the front, so the render thread can draw
+/// from the front palettes while the next update runs
+class Animator
+{
+public:
+  /// @brief threads workers besides the caller, 0 picks one less than the
+  /// hardware threads
+  Animator(size_t threads = 0);
+  ~Animator();
+
+  /// @brief waits for a running update first. the instance stays valid
+  /// until the animator is destroyed
+  AnimatedInstance &add(Model *model, const Transform &transform, int clip, float timeOffset = 0.0f);
+  size_t size();
+  AnimatedInstance &getInstance(size_t index);
+
+  /// @brief levels by descending coverage, an instance uses the last one
+  /// whose coverage it is under. joints whose subtree covers less of the
+  /// screen height than jointCoverage are not sampled and hold their last
+  /// value (fingers and facial bones of distant characters), see
+  /// Skeleton::jointExtents.
+  /// no levels and a jointCoverage of 0 animate everything at full detail
+  void setLod(const std::vector<AnimationLod> &levels, float jointCoverage);
+  /// @brief the camera coverage is measured with from the next begin on.
+  /// without one every instance counts as full screen
+  void setCamera(const Mat4x4 &view, const Mat4x4 &projection);
+
+  /// @brief starts animating every instance at time, returns right away
+  void begin(float time);
+  /// @brief helps with the remaining jobs, waits for the workers and
+  /// publishes the new palettes. does nothing without a running update
+  void finish();
+
+private:
+  std::deque<AnimatedInstance> instances;
+  std::vector<std::thread> workers;
+
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable done;
+  // bumped by begin, workers run the jobs once per value
+  size_t generation;
+  size_t remaining;
+  bool running;
+  bool stopping;
+
+  std::atomic<size_t> next;
+  float time;
+
+  std::vector<AnimationLod> lods;
+  float jointCoverage;
+  Mat4x4 view;
+  Mat4x4 projection;
+  bool hasCamera;
+
+  void work();
+  void runJobs();
+  void animate(AnimatedInstance &instance);
+  /// @brief picks the instance's lod and active joints, returns the
+  /// sampling interval
+  float updateLod(AnimatedInstance &instance);
+  float coverage(AnimatedInstance &instance);
+  bool crossesLoop(AnimatedInstance &instance, float time, float interval);
+  /// @brief samples the clip into pose and builds a palette from it,
+  /// masked leaves the inactive joints alone
+  void samplePalette(AnimatedInstance &instance, float time, bool masked, SkinPalette &out);
+  void blendKeys(AnimatedInstance &instance, float time, float interval, SkinPalette &out);
+};
+
+#endif
@@ -0,0 +1,91 @@
+#include "crowd.h"
+#include "../math/batch.h"
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+#include <algorithm>
+
+// kept off unit 0, which the fragment shader's pattern texture uses
+#define ANIMATION_TEXTURE_UNIT 1
+
+Crowd::Crowd(Model *model, float rate)
+    : model(model), buffer(0), dirty(false)
+{
+  this->texture.bake(*model, rate);
+  if (this->texture.clips.size() > MAX_BAKED_CLIPS)
+  {
+    std::cout << "crowd: only the first " << MAX_BAKED_CLIPS << " of "
+              << this->texture.clips.size() << " clips can be played" << std::endl;
+  }
+  this->texture.upload();
+
+  this->clipTable.resize(std::min(this->texture.clips.size(), (size_t)MAX_BAKED_CLIPS));
+  this->texture.getClipTable(this->clipTable);
+}
+
+void Crowd::add(const Transform &transform, int clip, float timeOffset)
+{
+  int last = (int)this->clipTable.size() - 1;
+  MeshInstance &instance = this->instances.emplace_back();
+  instance.transform = transform.get();
+  Mat3x4 affine = transform.getAffine();
+  normalBatch(std::span<const Mat3x4>(&affine, 1), std::span<Mat3x3>(&instance.normal, 1));
+  instance.animation = Vector2f((float)std::clamp(clip, 0, std::max(last, 0)), timeOffset);
+  this->dirty = true;
+}
+
+size_t Crowd::size() { return this->instances.size(); }
+
+void Crowd::render(Shader &shader, float time)
+{
+  if (this->instances.empty() || this->clipTable.empty())
+  {
+    return;
+  }
+
+  if (this->dirty)
+  {
+    bool created = this->buffer == 0;
+    if (created)
+    {
+      glCreateBuffers(1, &this->buffer);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, this->buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(MeshInstance) * this->instances.size(),
+                 this->instances.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // attached only once the buffer holds an instance, the model's own
+    // draws read instance 0 of it through the same vertex arrays
+    if (created)
+    {
+      for (Mesh &mesh : this->model->meshes)
+      {
+        mesh.setInstances(this->buffer);
+      }
+    }
+    this->dirty = false;
+  }
+
+  shader.use();
+  shader.updateInt("textured", false);
+  shader.updateVec3("inColor", this->model->color);
+  shader.updateFloat("time", time);
+  shader.updateInt("animationTexture", ANIMATION_TEXTURE_UNIT);
+  shader.updateVec4("clips", this->clipTable);
+  this->texture.bind(ANIMATION_TEXTURE_UNIT);
+
+  for (Mesh &mesh : this->model->meshes)
+  {
+    mesh.renderInstanced(this->instances.size());
+  }
+
+  glActiveTexture(GL_TEXTURE0);
+}
+
+void Crowd::clean()
+{
+  this->texture.clean();
+  glDeleteBuffers(1, &this->buffer);
+}
@@ -0,0 +1,41 @@
+#ifndef CROWD_H
+#define CROWD_H
+
+#include "../model/model.h"
+
+#include <vector>
+
+/// @brief many copies of one model playing baked clips, drawn with one
+/// instanced draw per mesh. the clips are baked into an AnimationTexture
+/// once, after that an instance is only its transform, clip and time offset
+/// and the vertex shader does all of the animation. meant for background
+/// characters, no blending, layers or lod
+class Crowd
+{
+public:
+  /// @brief bakes model's clips at rate frames per second and uploads them,
+  /// needs a gl context
+  Crowd(Model *model, float rate);
+  ~Crowd() {}
+
+  /// @brief the instance buffer is rebuilt by the next render
+  void add(const Transform &transform, int clip, float timeOffset = 0.0f);
+  size_t size();
+
+  /// @brief draws every instance at time, shader being one built from
+  /// shaders/animationBaked.vs with view and projection already set
+  void render(class Shader &shader, float time);
+  void clean();
+
+  Model *model;
+  AnimationTexture texture;
+
+private:
+  std::vector<MeshInstance> instances;
+  std::vector<Vector4f> clipTable;
+  unsigned int buffer;
+  // instances changed since the buffer was last filled
+  bool dirty;
+};
+
+#endif
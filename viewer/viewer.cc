@@ -1,21 +1,45 @@
 #include "viewer.h"
 #include "../model/model.h"
+#include "../math/batch.h"
+#include "animator.h"
+#include "crowd.h"
 
 #include <filesystem>
 #include <format>
 
 Viewer::Viewer()
     : camera(new Camera()),
+      animator(new Animator()),
       currModel("None"),
       lightDir(Vector3f(0.5, -0.5, 0.5)),
+      clipBakeRate(60.0f),
+      compressClips(false),
+      packClips(false),
+      crowdBakeRate(30.0f),
       phongStatic(nullptr),
       phongAnimated(nullptr),
+      phongDualQuat(nullptr),
+      phongBaked(nullptr),
       pbrStatic(nullptr),
-      pbrAnimated(nullptr) {}
+      pbrAnimated(nullptr),
+      time(0.0f)
+{
+  // instances under a third of the screen height update at 30Hz, then 15
+  // and 8 as they shrink. joints reaching less than 0.2% of the screen
+  // height (about 2 pixels at 1080p) are not animated
+  this->animator->setLod({{0.3f, 1.0f / 30.0f}, {0.12f, 1.0f / 15.0f}, {0.05f, 1.0f / 8.0f}}, 0.002f);
+}
 
 Viewer::~Viewer()
 {
   delete this->camera;
+  // the workers read the models
+  delete this->animator;
+  for (auto &crowd : crowds)
+  {
+    crowd.second->clean();
+    delete crowd.second;
+  }
   for (auto &model : models)
   {
     model.second->clean();
@@ -27,6 +51,8 @@ void Viewer::init()
 {
   this->phongStatic = new Shader("shaders/shader.vs", "shaders/shader.fs");
   this->phongAnimated = new Shader("shaders/animation.vs", "shaders/shader.fs");
+  this->phongDualQuat = new Shader("shaders/animationDQ.vs", "shaders/shader.fs");
+  this->phongBaked = new Shader("shaders/animationBaked.vs", "shaders/shader.fs");
 }
 
 void Viewer::addModel(std::string name, std::string path)
@@ -34,7 +60,7 @@ void Viewer::addModel(std::string name, std::string path)
 
   Model *model = new Model();
   GLTFFile file = GLTFFile(path);
-  file.populateModel(*model);
+  file.populateModel(*model, this->clipBakeRate, this->compressClips ? &this->clipCompression : nullptr, this->packClips);
   model->scale(Vector3f(0.5));
   model->orient(Quat(180.0, Vector3f(0.0, 1.0, 0.0)));
   model->translate(Vector3f(0.0, 0.0, 10.0));
@@ -42,6 +68,21 @@ void Viewer::addModel(std::string name, std::string path)
   this->models.insert(std::make_pair(name, model));
 }
 
+void Viewer::addInstance(std::string model, const Transform &transform, int clip, float timeOffset)
+{
+  this->animator->add(this->models[model], transform, clip, timeOffset);
+}
+
+void Viewer::addCrowdInstance(std::string model, const Transform &transform, int clip, float timeOffset)
+{
+  Crowd *&crowd = this->crowds[model];
+  if (crowd == nullptr)
+  {
+    crowd = new Crowd(this->models[model], this->crowdBakeRate);
+  }
+  crowd->add(transform, clip, timeOffset);
+}
+
 void Viewer::update(float ratio, float elapsed)
 {
 
@@ -51,12 +92,20 @@ void Viewer::update(float ratio, float elapsed)
   this->phongStatic->updateMat4("view", this->camera->view());
   this->phongStatic->updateMat4("projection", this->camera->projection(ratio)); */
 
-  this->phongAnimated->use();
-  this->phongAnimated->updateVec3("lightDirection", this->lightDir);
-  this->phongAnimated->updateVec3("viewPos", this->camera->pos);
-  this->phongAnimated->updateMat4("view", this->camera->view());
-  this->phongAnimated->updateMat4("projection", this->camera->projection(ratio));
+  for (Shader *shader : {this->phongAnimated, this->phongDualQuat, this->phongBaked})
+  {
+    shader->use();
+    shader->updateVec3("lightDirection", this->lightDir);
+    shader->updateVec3("viewPos", this->camera->pos);
+    shader->updateMat4("view", this->camera->view());
+    shader->updateMat4("projection", this->camera->projection(ratio));
+  }
   this->models[this->currModel]->animate(elapsed);
+  this->time = elapsed;
+
+  // publishes the palettes of the last update and starts the next one
+  this->animator->setCamera(this->camera->view(), this->camera->projection(ratio));
+  this->animator->begin(elapsed);
 }
 
 void Viewer::renderCurrModel()
@@ -70,19 +119,83 @@ void Viewer::renderCurrModel()
     this->models[this->currModel]->render();
   } */
 
-  this->phongAnimated->use();
-  this->phongAnimated->updateInt("textured", false);
   if (this->currModel != "None")
   {
-    this->phongAnimated->updateVec3("inColor", this->models[this->currModel]->color);
-    this->phongAnimated->updateMat4("transform", this->models[this->currModel]->get_transform());
+    Model *model = this->models[this->currModel];
+    Shader *shader = model->skinning == SkinDualQuat ? this->phongDualQuat : this->phongAnimated;
 
-    std::vector<Mat4x4> mats = this->models[this->currModel]->getPose();
-    for (int i = 0; i < mats.size(); i++)
+    shader->use();
+    shader->updateInt("textured", false);
+    shader->updateVec3("inColor", model->color);
+    shader->updateMat4("transform", model->get_transform());
+    shader->updateMat3("normalMat", model->get_normal_transform());
+
+    // the palettes keep their size between frames, resize only allocates
+    // when a model with more joints shows up
+    if (model->isAnimated() && model->skinning == SkinDualQuat)
     {
-      std::string value = "boneMats[" + std::to_string(i) + "]";
-      this->phongAnimated->updateMat4(value.c_str(), mats[i]);
+      this->dualPalette.resize(model->jointCount());
+      model->getDualPose(this->dualPalette);
+      shader->updateDualQuat("boneDQs", this->dualPalette);
     }
-    this->models[this->currModel]->render();
+    else if (model->isAnimated())
+    {
+      this->palette.resize(model->jointCount());
+      model->getPose(this->palette);
+      shader->updateStorage("BoneMats", this->palette);
+
+      this->normalPalette.resize(model->jointCount());
+      bool rigid = !model->getNormalPose(this->palette, this->normalPalette);
+      shader->updateInt("rigidBones", rigid);
+      if (!rigid)
+      {
+        shader->updateStorage("BoneNormals", this->normalPalette);
+      }
+    }
+    model->render();
   }
-}
\ No newline at end of file
+}
+
+void Viewer::renderInstances()
+{
+  for (size_t i = 0; i < this->animator->size(); i++)
+  {
+    const AnimatedInstance &instance = this->animator->getInstance(i);
+    const SkinPalette &palette = instance.palette();
+    Model *model = instance.model;
+    Shader *shader = model->skinning == SkinDualQuat ? this->phongDualQuat : this->phongAnimated;
+
+    Mat3x4 affine = instance.transform.getAffine();
+    Mat3x3 normalMat;
+    normalBatch(std::span<const Mat3x4>(&affine, 1), std::span<Mat3x3>(&normalMat, 1));
+
+    shader->use();
+    shader->updateInt("textured", false);
+    shader->updateVec3("inColor", model->color);
+    shader->updateMat4("transform", instance.transform.get());
+    shader->updateMat3("normalMat", normalMat);
+
+    if (model->skinning == SkinDualQuat)
+    {
+      shader->updateDualQuat("boneDQs", palette.dualQuats);
+    }
+    else
+    {
+      shader->updateStorage("BoneMats", palette.mats);
+      shader->updateInt("rigidBones", palette.rigid);
+      if (!palette.rigid)
+      {
+        shader->updateStorage("BoneNormals", palette.normals);
+      }
+    }
+    model->render();
+  }
+}
+
+void Viewer::renderCrowds()
+{
+  for (auto &crowd : this->crowds)
+  {
+    crowd.second->render(*this->phongBaked, this->time);
+  }
+}
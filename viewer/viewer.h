@@ -3,8 +3,10 @@
 
 #include <map>
 #include <string>
+#include <vector>
 #include "camera.h"
 #include "../math/math.h"
+#include "../model/animation/compressedClip.h"
 
 class Shader;
 
@@ -17,24 +19,57 @@ public:
   void init();
 
   void addModel(std::string name, std::string path);
+  /// @brief another character drawn with an added model, animated on the
+  /// animator's worker threads
+  void addInstance(std::string model, const Transform &transform, int clip = 0, float timeOffset = 0.0f);
+  /// @brief a character of the model's crowd, animated entirely on the gpu
+  /// from clips baked at crowdBakeRate when the crowd gets its first one
+  void addCrowdInstance(std::string model, const Transform &transform, int clip = 0, float timeOffset = 0.0f);
 
   void update(float ratio, float elapsed);
   void renderCurrModel();
+  /// @brief draws every instance with the palettes of the previous update,
+  /// the current one runs on the workers meanwhile
+  void renderInstances();
+  /// @brief one instanced draw per mesh of every crowd
+  void renderCrowds();
 
   Camera *camera;
+  class Animator *animator;
 
   std::string currModel;
 
   Vector3f lightDir;
+  /// @brief keys per second clips get resampled to when a model is added,
+  /// 0 keeps the keys from the file
+  float clipBakeRate;
+  /// @brief compress clips when a model is added, see Clip::compress
+  bool compressClips;
+  CompressionSettings clipCompression;
+  /// @brief pack clips into one block per clip at clipBakeRate instead of
+  /// baking them, see Clip::pack
+  bool packClips;
+  /// @brief frames per second of the animation textures crowds play from
+  float crowdBakeRate;
 
 private:
   Shader *phongStatic;
   Shader *phongAnimated;
+  Shader *phongDualQuat;
+  Shader *phongBaked;
 
   Shader *pbrStatic;
   Shader *pbrAnimated;
 
+  // skin palettes of the model being drawn, reused every frame
+  std::vector<Mat3x4> palette;
+  std::vector<Mat3x3> normalPalette;
+  std::vector<DualQuat> dualPalette;
+
   std::map<std::string, class Model *> models;
+  std::map<std::string, class Crowd *> crowds;
+  // elapsed of the last update, the time crowds are drawn at
+  float time;
 };
 
 #endif
\ No newline at end of file